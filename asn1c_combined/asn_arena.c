@@ -0,0 +1,187 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#include "asn_arena.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Every allocation is preceded by a header holding its size (REALLOC needs it) and keeps this alignment. */
+#define ARENA_ALIGN         16
+#define ARENA_ROUND(n)      (((n) + (ARENA_ALIGN - 1)) & ~(size_t)(ARENA_ALIGN - 1))
+
+typedef struct asn_arena_block_s {
+    struct asn_arena_block_s *next;
+    size_t size;                /* usable bytes after the block header */
+    size_t used;
+} asn_arena_block_t;
+
+#define BLOCK_HEADER        ARENA_ROUND(sizeof(asn_arena_block_t))
+#define BLOCK_DATA(b)       ((char *)(b) + BLOCK_HEADER)
+#define ALLOC_SIZE(p)       (*(size_t *)((char *)(p) - ARENA_ALIGN))
+
+struct asn_arena_s {
+    asn_arena_block_t *head;
+    asn_arena_block_t *current;     /* blocks after this one are empty */
+    size_t block_size;
+    size_t used;
+    void *last;                     /* the most recent allocation; it can grow in place */
+};
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_THREADS__)
+static _Thread_local asn_arena_t *thread_arena;
+#else
+static __thread asn_arena_t *thread_arena;
+#endif
+
+asn_arena_t *asn_arena_create(size_t block_size) {
+    asn_arena_t *arena = calloc(1, sizeof(*arena));
+    if(arena) arena->block_size = block_size ? ARENA_ROUND(block_size) : 65536;
+    return arena;
+}
+
+void asn_arena_destroy(asn_arena_t *arena) {
+    asn_arena_block_t *b;
+
+    if(!arena) return;
+    if(thread_arena == arena) thread_arena = NULL;
+
+    while((b = arena->head)) {
+        arena->head = b->next;
+        free(b);
+    }
+    free(arena);
+}
+
+void asn_arena_reset(asn_arena_t *arena) {
+    asn_arena_block_t *b;
+
+    for(b = arena->head; b; b = b->next) b->used = 0;
+    arena->current = arena->head;
+    arena->used = 0;
+    arena->last = NULL;
+}
+
+asn_arena_t *asn_arena_use(asn_arena_t *arena) {
+    asn_arena_t *previous = thread_arena;
+    thread_arena = arena;
+    return previous;
+}
+
+size_t asn_arena_used(const asn_arena_t *arena) {
+    return arena->used;
+}
+
+static int arena_owns(const asn_arena_t *arena, const void *ptr) {
+    const asn_arena_block_t *b;
+
+    for(b = arena->head; b; b = b->next) {
+        if((const char *)ptr >= BLOCK_DATA(b) && (const char *)ptr < BLOCK_DATA(b) + b->size) return 1;
+    }
+    return 0;
+}
+
+static void *arena_alloc(asn_arena_t *arena, size_t size) {
+    size_t need;
+    asn_arena_block_t *b;
+    char *p;
+
+    if(size > SIZE_MAX - 2 * ARENA_ALIGN) return NULL;
+    need = ARENA_ROUND(size) + ARENA_ALIGN;
+
+    /* the rest of a block that is too small is skipped until the next reset. */
+    for(b = arena->current; b && b->size - b->used < need; b = b->next)
+        ;
+
+    if(!b) {
+        size_t size = need > arena->block_size ? need : arena->block_size;
+        asn_arena_block_t **tail = &arena->head;
+
+        b = malloc(BLOCK_HEADER + size);
+        if(!b) return NULL;
+        b->next = NULL;
+        b->size = size;
+        b->used = 0;
+
+        while(*tail) tail = &(*tail)->next;
+        *tail = b;
+    }
+
+    arena->current = b;
+    p = BLOCK_DATA(b) + b->used + ARENA_ALIGN;
+    b->used += need;
+    arena->used += need;
+
+    ALLOC_SIZE(p) = size;
+    arena->last = p;
+    return p;
+}
+
+void *asn_arena_malloc(size_t size) {
+    return thread_arena ? arena_alloc(thread_arena, size) : malloc(size);
+}
+
+void *asn_arena_calloc(size_t nmemb, size_t size) {
+    void *p;
+
+    if(!thread_arena) return calloc(nmemb, size);
+    if(size && nmemb > SIZE_MAX / size) return NULL;
+
+    p = arena_alloc(thread_arena, nmemb * size);
+    if(p) memset(p, 0, nmemb * size);
+    return p;
+}
+
+void *asn_arena_realloc(void *ptr, size_t size) {
+    asn_arena_t *arena = thread_arena;
+    size_t old_size;
+    void *p;
+
+    if(!arena || !ptr || !arena_owns(arena, ptr)) {
+        return (arena && !ptr) ? arena_alloc(arena, size) : realloc(ptr, size);
+    }
+
+    old_size = ALLOC_SIZE(ptr);
+    if(size <= old_size) return ptr;
+
+    /* growing buffers (OCTET STRINGs, SEQUENCE OF arrays) are usually the latest allocation; extend them in place. */
+    if(ptr == arena->last) {
+        asn_arena_block_t *b = arena->current;
+        size_t grow = ARENA_ROUND(size) - ARENA_ROUND(old_size);
+        if(size <= SIZE_MAX - ARENA_ALIGN && b->size - b->used >= grow) {
+            b->used += grow;
+            arena->used += grow;
+            ALLOC_SIZE(ptr) = size;
+            return ptr;
+        }
+    }
+
+    p = arena_alloc(arena, size);
+    if(p) memcpy(p, ptr, old_size);
+    return p;
+}
+
+void asn_arena_free(void *ptr) {
+    /* arena memory is released by asn_arena_reset. */
+    if(thread_arena && ptr && arena_owns(thread_arena, ptr)) return;
+    free(ptr);
+}
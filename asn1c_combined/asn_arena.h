@@ -0,0 +1,82 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+/*
+ * A bump allocator for the asn1c skeletons.
+ *
+ * doIt.sh includes this file at the end of the generated asn_internal.h, so the skeletons' CALLOC, MALLOC, REALLOC and
+ * FREEMEM go through the functions below. While a thread has an arena in use, those allocations come from the arena and
+ * FREEMEM of arena memory does nothing; the whole decoded structure is released with one asn_arena_reset instead of
+ * ASN_STRUCT_FREE. Without an arena in use they behave exactly like the C library functions.
+ */
+
+#ifndef ASN_ARENA_H
+#define ASN_ARENA_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct asn_arena_s asn_arena_t;
+
+/* An empty arena that takes memory from the heap in blocks of (at least) block_size bytes; NULL if out of memory. */
+asn_arena_t *asn_arena_create(size_t block_size);
+
+/* Free the arena and all of its memory; stops using it on this thread if it is in use. */
+void asn_arena_destroy(asn_arena_t *arena);
+
+/* Release everything allocated from the arena at once; the blocks are kept for reuse. */
+void asn_arena_reset(asn_arena_t *arena);
+
+/* Allocate from arena on the calling thread until the next call (NULL returns to the heap); returns the previous one. */
+asn_arena_t *asn_arena_use(asn_arena_t *arena);
+
+/* The number of bytes allocated from the arena since it was created or reset. */
+size_t asn_arena_used(const asn_arena_t *arena);
+
+void *asn_arena_malloc(size_t size);
+void *asn_arena_calloc(size_t nmemb, size_t size);
+void *asn_arena_realloc(void *ptr, size_t size);
+void asn_arena_free(void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* ASN_ARENA_H */
+
+/* Only the skeletons (which include asn_internal.h) are redirected; other users of this header keep the C library. */
+#if defined(ASN_INTERNAL_H) && !defined(ASN_ARENA_MACROS)
+#define ASN_ARENA_MACROS
+
+#undef CALLOC
+#undef MALLOC
+#undef REALLOC
+#undef FREEMEM
+
+#define CALLOC(nmemb, size)     asn_arena_calloc(nmemb, size)
+#define MALLOC(size)            asn_arena_malloc(size)
+#define REALLOC(oldptr, size)   asn_arena_realloc(oldptr, size)
+#define FREEMEM(ptr)            asn_arena_free(ptr)
+
+#endif
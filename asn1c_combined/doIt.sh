@@ -12,4 +12,10 @@ asn1c -fcompound-names -gen-PER -gen-OER -pdu=all \
 
 sed -i 's/\(-DASN_PDU_COLLECTION\)/-DPDU=MessageFrame \1/' converter-example.mk
 
+# Route the skeleton's CALLOC/MALLOC/REALLOC/FREEMEM through the decode arena (asn_arena.h); the ACM frees a whole
+# decoded message with one arena reset.
+echo '#include "asn_arena.h"' >> asn_internal.h
+echo 'ASN_MODULE_SRCS+=./asn_arena.c' >> Makefile.am.libasncodec
+echo 'ASN_MODULE_HDRS+=./asn_arena.h' >> Makefile.am.libasncodec
+
 make -f converter-example.mk
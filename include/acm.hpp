@@ -64,18 +64,37 @@
 #include "pugixml.hpp"
 
 #include "acmLogger.hpp"
-
+#include "affinity.hpp"
+#include "asn_arena.h"
+#include "asn1_cbor.hpp"
+#include "asn1_dom.hpp"
+#include "asn1_json.hpp"
+#include "asn1_registry.hpp"
+#include "bsm_columns.hpp"
+#include "encode_buffer.hpp"
+#include "hex_codec.hpp"
+#include "output_buffer.hpp"
+#include "partition_pauses.hpp"
+#include "partition_tracker.hpp"
+#include "projection.hpp"
+#include "spsc_ring.hpp"
+#include "stealing_queue.hpp"
+#include "uper_skip.hpp"
+#include "xml_splice.hpp"
+
+#include <atomic>
+#include <chrono>
 #include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
 #include <utility>
 #include <tuple>
+#include <unordered_map>
 #include <sstream>
 
-typedef struct buffer_structure {
-    char *buffer;
-    size_t buffer_size;      // this is really where we will write next.
-    size_t allocated_size;   // this is the total size of the buffer.
-} buffer_structure_t;
-
 enum class Asn1ErrorType : uint32_t {
     SUCCESS = 0,            // not used.
     FAILURE,                // not used.
@@ -92,6 +111,13 @@ enum class Asn1DataType : uint32_t {
     COUNT
 };
 
+enum class OutputFormat : uint32_t {
+    XML = 0,                // the OdeAsn1Data document; the default.
+    JSON,                   // the same document as JSON.
+    CBOR,                   // the same document as CBOR (RFC 8949).
+    COUNT
+};
+
 // an enumeration that specifies which bit in a flag word is used to turn on and off certain operations.
 enum class Asn1OpsType : uint32_t {
 	IEEE1609DOT2 = 1,			// 1<<0
@@ -198,6 +224,153 @@ class Asn1CodecError : public std::runtime_error {
         }
 };
 
+/**
+ * @brief The work the encodings metadata of a message asks for, compiled once for each distinct encodings block.
+ *
+ * A topic carries only a few distinct encodings blocks, so the decode flags, the transfer syntaxes, and the ordered
+ * encoding steps (with their node paths already split into names) are worked out the first time a block is seen and
+ * reused for every later message with the same block.
+ */
+struct CodecPlan {
+    struct EncodeStep {
+        const asn_TYPE_descriptor_t* type;                          ///> The type of the node to encode.
+        enum asn_transfer_syntax syntax;
+        std::string path;                                           ///> The node's path relative to the payload data, for messages.
+        std::vector<std::string> path_names;                        ///> path split at each '/'.
+        bool replace;                                               ///> Replace the node by its hex string; otherwise only report it.
+    };
+
+    CodecPlan();
+
+    uint32_t opsflag;
+    bool decode_1609dot2;
+    bool decode_messageframe;
+    bool decode_asdframe;
+
+    enum asn_transfer_syntax decode_1609dot2_type;
+    enum asn_transfer_syntax decode_messageframe_type;
+    enum asn_transfer_syntax decode_asdframe_type;
+    const asn_TYPE_descriptor_t* messageframe_pdu;                  ///> The innermost type: MessageFrame, or the PDU the input names instead.
+
+    bool encodable;                                                 ///> The combination of types is one this module can encode.
+    std::vector<EncodeStep> encode_steps;                           ///> Innermost node first.
+};
+
+/**
+ * @brief When the structures of one ASN.1 type are checked against the type's constraints (asn_check_constraints).
+ *
+ * The PER and OER decoders already reject most values outside their constraints, so the check after a decode is a
+ * second walk of the structure that trusted, high-rate sources can sample or skip; structures built from XML for
+ * encoding are not checked by anything else.
+ */
+struct ConstraintPolicy {
+    enum class Mode {
+        ALWAYS,                                                     ///> Every decode and encode.
+        SAMPLE,                                                     ///> One in sample_interval decodes; every encode.
+        ENCODE,                                                     ///> Every encode; no decodes.
+        OFF                                                         ///> Never.
+    };
+
+    ConstraintPolicy() :
+        mode{ Mode::ALWAYS }
+        , sample_interval{ 1 }
+    {}
+
+    /**
+     * @brief Parse always, sample:N, encode, or off.
+     *
+     * @return false if the text is none of these; the policy is unchanged.
+     */
+    bool parse( const std::string& text );
+
+    Mode mode;
+    uint32_t sample_interval;
+};
+
+/**
+ * @brief Allocates the asn1c skeleton's memory on this thread from an arena (or the heap, for null) while in scope.
+ *
+ * The thread's previous arena is restored however the scope is left, so an exception never leaves a worker's arena
+ * installed for allocations that are not meant to come from it.
+ */
+class ArenaScope {
+    public:
+        explicit ArenaScope( asn_arena_t* arena ) :
+            previous_{ asn_arena_use( arena ) }
+        {}
+
+        ArenaScope( const ArenaScope& ) = delete;
+        ArenaScope& operator=( const ArenaScope& ) = delete;
+
+        ~ArenaScope() {
+            asn_arena_use( previous_ );
+        }
+
+    private:
+        asn_arena_t* previous_;
+};
+
+/**
+ * @brief The per-message working state of the codec: the parsed input document, scratch buffers, and the encoding
+ * plan derived from the message's metadata. Each codec worker owns exactly one of these, so any number of messages can
+ * be decoded or encoded in parallel without sharing mutable state.
+ */
+struct CodecContext {
+    static constexpr std::size_t max_errbuf_size = 128;             ///> The length of error buffers for ASN.1 compiler.
+
+    CodecContext();
+    ~CodecContext();
+
+    CodecContext( const CodecContext& ) = delete;
+    CodecContext& operator=( const CodecContext& ) = delete;
+
+    pugi::xml_document input_doc;
+    pugi::xml_document internal_doc;
+    pugi::xml_document error_doc;                                   ///> This worker's copy of the error template; it is modified per error.
+
+    std::ostringstream erroross;
+    std::vector<char> byte_buffer;                                  ///> storage for hex to byte and byte to hex encoder/decoder.
+    asn1_dom::Builder dom_builder;                                  ///> Builds decoded structures straight into input_doc.
+    XmlSplice output_splice;                                        ///> Writes the output as the input text with the payload replaced.
+    asn1_json::Writer json_writer;                                  ///> Writes decoded structures as JSON for the JSON output format.
+    asn1_cbor::Writer cbor_writer;                                  ///> Writes decoded structures as CBOR for the CBOR output format.
+    std::string encoded_payload;                                    ///> The decoded structure as JSON or CBOR; written in place of encoded_payload_node.
+    pugi::xml_node encoded_payload_node;
+    EncodeBuffer encode_buffer;                                     ///> Binary output of the ASN.1 encoders; keeps its memory between messages.
+
+    // ASN.1 Compiler
+    asn_arena_t* arena;                                             ///> Holds the structure being decoded or encoded; null allocates from the heap.
+    std::size_t errlen;
+    char errbuf[max_errbuf_size];
+
+    uint32_t opsflag;
+    bool decode_1609dot2;
+    bool decode_messageframe;
+    bool decode_asdframe;
+
+    enum asn_transfer_syntax decode_1609dot2_type;
+    enum asn_transfer_syntax decode_messageframe_type;
+    enum asn_transfer_syntax decode_asdframe_type;
+    const asn_TYPE_descriptor_t* messageframe_pdu;                  ///> The innermost type: MessageFrame, or the PDU the input names instead.
+
+    pugi::xml_node payload_node_;
+
+    std::vector<std::tuple<std::string, std::string>> hex_data_;
+
+    // compiled plans by encodings block; private to this context, so no locking.
+    static constexpr std::size_t max_plans = 64;                    ///> The cache starts over when it holds this many plans.
+    std::unordered_map<std::string, CodecPlan> plans;
+    std::string plan_key;                                           ///> The elementType and encodingRule of each encodings entry.
+    const CodecPlan* plan;                                          ///> The plan of the current message.
+
+    std::size_t output_size_hint;                                   ///> Bytes reserved for the next output buffer; the size of the last output.
+
+    std::unordered_map<const asn_TYPE_descriptor_t*, uint32_t> constraint_samples;   ///> Decodes since each type was last checked.
+
+    BsmBatch bsm_batch;                                             ///> Decoded BSM core data not yet written as a columnar batch.
+    std::string bsm_batch_output;                                   ///> The columnar form of the batch being written.
+};
+
 class ASN1_Codec : public tool::Tool {
 
     public:
@@ -214,7 +387,7 @@ class ASN1_Codec : public tool::Tool {
         bool configure();
         bool launch_consumer();
         bool launch_producer();
-        bool process_message(RdKafka::Message* message, std::stringstream& output_message_stream);
+        bool process_message(CodecContext& ctx, RdKafka::Message* message, pugi::xml_writer& output);
         bool filetest();
         bool file_test(std::string file_path, std::ostream& os, bool encode = true);
         int operator()(void);
@@ -235,10 +408,80 @@ class ASN1_Codec : public tool::Tool {
 
     private:
 
-        static bool bootstrap;                                          ///> flag indicating we need to bootstrap the consumer and producer
-        static bool data_available;                                     ///> flag to exit application; set via signals so static.
+        /**
+         * @brief librdkafka delivery report callback; the published counters are only updated once the broker has
+         * acknowledged a message.
+         */
+        class DeliveryReporter : public RdKafka::DeliveryReportCb {
+            public:
+                explicit DeliveryReporter( ASN1_Codec& codec ) : codec_{ codec } {}
+                void dr_cb( RdKafka::Message& message ) override;
 
-        static constexpr std::size_t max_errbuf_size = 128;             ///> The length of error buffers for ASN.1 compiler.
+            private:
+                ASN1_Codec& codec_;
+        };
+
+        /**
+         * @brief librdkafka rebalance callback; runs on the consumer thread inside consume(). Handles both the eager and
+         * the cooperative (incremental) protocols.
+         */
+        class Rebalancer : public RdKafka::RebalanceCb {
+            public:
+                explicit Rebalancer( ASN1_Codec& codec ) : codec_{ codec } {}
+                void rebalance_cb( RdKafka::KafkaConsumer* consumer, RdKafka::ErrorCode err, std::vector<RdKafka::TopicPartition*>& partitions ) override;
+
+            private:
+                ASN1_Codec& codec_;
+        };
+
+        using PartitionKey = std::pair<std::string, int32_t>;           ///< topic and partition.
+
+        /**
+         * @brief An output held while the producer is full, and the offset of its partition to store once the output is
+         * queued; an entry with no topic only stores the offset.
+         */
+        struct HeldOutput {
+            OutputBuffer output;
+            RdKafka::Topic* topic;
+            PartitionKey key;
+            int64_t offset;                                             ///< -1 if no offset is stored after the output.
+        };
+
+        /**
+         * @brief One decode or encode flow: the topic it consumes, the topic its outputs are published to, and the
+         * direction. All pipelines share the Kafka clients and the codec workers.
+         */
+        struct Pipeline {
+            std::string name;
+            std::string consumer_topic;
+            std::string producer_topic;
+            bool decode;
+            std::shared_ptr<RdKafka::Topic> producer_topic_ptr;
+            bool raw_input;                                             ///< Record values are ASN.1 bytes, not OdeAsn1Data XML.
+            std::string raw_plan_key;                                   ///< Encodings of raw records without an encodings header.
+        };
+
+        /**
+         * @brief A finished message on its way from a codec worker to the egress stage; the message is kept until its
+         * output has been released so its topic, partition, and offset can be tracked.
+         */
+        struct CodecResult {
+            std::unique_ptr<RdKafka::Message> message;
+            OutputBuffer output;
+        };
+
+        /**
+         * @brief The position of a consumed message, sent from the ingest stage to the egress stage before the message
+         * itself is dispatched, so egress always tracks an offset before its result arrives.
+         */
+        struct ConsumedOffset {
+            std::string topic;
+            int32_t partition;
+            int64_t offset;
+        };
+
+        static bool bootstrap;                                          ///> flag indicating we need to bootstrap the consumer and producer
+        static std::atomic<bool> data_available;                        ///> flag to exit application; set via signals so static.
 
         // possible encoding configurations.
         static constexpr uint32_t IEEE1609DOT2 = 1;
@@ -253,13 +496,75 @@ class ASN1_Codec : public tool::Tool {
         int32_t eof_cnt;                                                ///> counts the number of eofs needed for exit_eof to work; each partition must end.
         int32_t partition_cnt;                                          ///> TODO: the number of partitions being processed; currently 1.
 
-        // bookkeeping.
-        uint64_t msg_recv_count;                                        ///> Counter for the number of BSMs received.
-        uint64_t msg_send_count;                                        ///> Counter for the number of BSMs published.
-        uint64_t msg_filt_count;                                        ///> Counter for hte number of BSMs filtered/suppressed.
-        uint64_t msg_recv_bytes;                                        ///> Counter for the number of BSM bytes received.
-        uint64_t msg_send_bytes;                                        ///> Counter for the nubmer of BSM bytes published.
-        uint64_t msg_filt_bytes;                                        ///> Counter for the nubmer of BSM bytes filtered/suppressed.
+        // bookkeeping; updated from every codec worker.
+        std::atomic<uint64_t> msg_recv_count;                           ///> Counter for the number of BSMs received.
+        std::atomic<uint64_t> msg_send_count;                           ///> Counter for the number of BSMs published.
+        std::atomic<uint64_t> msg_filt_count;                           ///> Counter for hte number of BSMs filtered/suppressed.
+        std::atomic<uint64_t> msg_recv_bytes;                           ///> Counter for the number of BSM bytes received.
+        std::atomic<uint64_t> msg_send_bytes;                           ///> Counter for the nubmer of BSM bytes published.
+        std::atomic<uint64_t> msg_filt_bytes;                           ///> Counter for the nubmer of BSM bytes filtered/suppressed.
+        std::atomic<uint64_t> msg_fail_count;                           ///> Counter for the number of outputs the broker did not accept.
+        std::atomic<uint64_t> constraint_checks;                        ///> Structures checked against their ASN.1 constraints.
+        std::atomic<uint64_t> constraint_violations;                    ///> Checked structures that failed.
+
+        ConstraintPolicy default_constraint_policy;                     ///> For types without their own policy.
+        std::unordered_map<const asn_TYPE_descriptor_t*, ConstraintPolicy> constraint_policies;
+        std::unordered_map<const asn_TYPE_descriptor_t*, Projection> projections;   ///> The parts of each decoded type to output.
+
+        // staged pipeline: ingest (consumer thread) -> codec workers -> egress. Workers take from their own run queue and
+        // steal from the others when it is empty; results go to egress through SPSC rings.
+        std::size_t codec_threads;                                      ///> Number of codec workers; 1 processes messages on the consumer thread.
+        std::size_t codec_queue_size;                                   ///> Capacity of each queue or ring between two stages.
+        std::size_t arena_block_size;                                   ///> Block size of each worker's decode arena; 0 allocates from the heap.
+        std::vector<std::unique_ptr<StealingQueue<std::unique_ptr<RdKafka::Message>>>> codec_inputs;   ///> ingest -> worker i (and thieves).
+        std::vector<std::unique_ptr<SpscRing<CodecResult>>> codec_outputs;                         ///> worker i -> egress.
+        std::unique_ptr<SpscRing<ConsumedOffset>> consumed_offsets;     ///> ingest -> egress, in consumption order.
+        std::vector<std::thread> codec_workers;
+        std::thread egress;
+        std::size_t next_worker;                                        ///> Round-robin dispatch position; ingest only.
+        std::atomic<bool> ingest_done;                                  ///> Set once ingest will dispatch nothing more.
+        std::atomic<std::size_t> workers_done;                          ///> Workers that have drained their input and exited.
+        std::atomic<uint64_t> msg_steal_count;                          ///> Messages processed by a worker other than the one they were dispatched to.
+
+        // per-partition output ordering and offset commits; owned by egress (or the consumer thread with one worker).
+        bool output_ordered;                                            ///> Publish in input order; otherwise in completion order.
+        OutputFormat output_format;                                     ///> Publish XML, JSON, or CBOR documents.
+
+        // columnar batches of decoded BSM core data; each worker fills its own batch.
+        bool bsm_batches;                                               ///> Collect batches; set when a directory or topic is configured.
+        std::size_t bsm_batch_rows;                                     ///> Rows that complete a batch.
+        std::chrono::milliseconds bsm_batch_age;                        ///> A batch is written once its first row is this old.
+        std::string bsm_batch_directory;                                ///> Directory that receives batch files; empty for none.
+        std::string bsm_batch_topic;                                    ///> Topic that receives batches; empty for none.
+        std::shared_ptr<RdKafka::Topic> bsm_batch_topic_ptr;
+        std::atomic<uint64_t> bsm_batch_count;                          ///> Batches written; also numbers the batch files.
+        std::atomic<uint64_t> bsm_batch_row_count;                      ///> Rows in the batches written.
+        std::map<PartitionKey, PartitionTracker<OutputBuffer>> partition_trackers;
+        PartitionPauses<PartitionKey> partition_pauses;                 ///> Partitions paused for their own backlog or for producer backpressure.
+        std::size_t partition_max_in_flight;                            ///> Backlog that pauses a partition; it resumes at half. 0 disables.
+
+        // consumer group membership.
+        Rebalancer rebalancer;
+        bool subscribed;                                                ///> The subscription is in place; a relaunch does not wait on the topics again.
+        bool rebalanced;                                                ///> A rebalance ran during the current batch; consumer thread only.
+        std::set<PartitionKey> revoked_partitions;                      ///> Partitions revoked by the last rebalance; consumer thread only.
+        uint64_t msg_tracked_count;                                     ///> Messages handed to the trackers; consumer thread only.
+        std::atomic<uint64_t> msg_completed_count;                      ///> Tracked messages that have completed.
+
+        // thread placement.
+        affinity::CpuList thread_cpus;                                  ///> Cpus for the ACM and librdkafka threads; empty leaves placement to the kernel.
+        int numa_node;                                                  ///> NUMA node the cpus were restricted to, or -1.
+
+        // asynchronous produce and delivery reports.
+        DeliveryReporter delivery_reporter;
+        std::thread delivery_poller;                                    ///> Serves delivery reports for the producer.
+        std::atomic<bool> delivery_polling;
+        std::atomic<bool> produce_backpressure;                         ///> Set while outputs are held for a full local produce queue.
+        std::deque<HeldOutput> held_outputs;                            ///> Outputs waiting for room, in order; owned with the trackers.
+
+        // batched consumption.
+        std::size_t batch_size;                                         ///> Most messages taken from the consumer per batch.
+        int64_t batch_linger_us;                                        ///> Longest wait (microseconds) to fill a batch after its first message.
 
         // Logging.
         std::string mode;
@@ -275,67 +580,92 @@ class ASN1_Codec : public tool::Tool {
         std::string brokers;
         int32_t partition;
         int64_t offset;
-        std::string published_topic_name;                               ///> The topic we are publishing filtered BSM to.
+        std::vector<Pipeline> pipelines;                                ///> Configured pipelines; one unless acm.pipelines is set.
+        std::unordered_map<std::string, std::size_t> pipeline_topics;  ///> consumer topic -> index of its pipeline.
         std::vector<std::string> consumed_topics;                       ///> consumer topics.
         std::shared_ptr<RdKafka::KafkaConsumer> consumer_ptr;
         std::shared_ptr<RdKafka::Producer> producer_ptr;
-        std::shared_ptr<RdKafka::Topic> published_topic_ptr;
 
-        // ODE XML input XPath queries and parse options.
-        pugi::xml_document input_doc;
-        pugi::xml_document internal_doc;
+        // ODE XML input XPath queries and parse options; the queries are only evaluated so they are shared by all workers.
         pugi::xml_document error_doc;                                   ///> A base XML document to use in responding to input XML parse errors.
 
         unsigned int xml_parse_options;
-        pugi::xpath_query ieee1609dot2_unsecuredData_query;
         pugi::xpath_query ode_payload_query;
-        pugi::xpath_query ode_encodings_query;
 
-        std::ostringstream erroross;
-		bool add_error_xml( pugi::xml_document& doc, Asn1DataType dt, Asn1ErrorType et, std::string message, bool update_time = false );
+        Asn1Registry asn1_types;                                        ///> Every PDU the ASN.1 specifications define, by name.
 
-        std::vector<char> byte_buffer;                                 ///> storage for hex to byte and byte to hex encoder/decoder.
+        CodecContext main_context;                                      ///> Codec state used by the consumer thread and the file tests.
 
+		bool add_error_xml( pugi::xml_document& doc, Asn1DataType dt, Asn1ErrorType et, std::string message, bool update_time = false );
 
         bool hex_to_bytes_(const std::string& payload_hex, std::vector<char>& byte_buffer);
-        bool bytes_to_hex_(buffer_structure_t* buf_struct, std::string& payload_hex );
-
-        // ASN.1 Compiler
-        std::size_t errlen;
-        char errbuf[max_errbuf_size];
-
-		// TODO: A byte flag word is needed here since we will set multiple decode / encoders.
-		uint32_t opsflag;
-        bool decode_1609dot2;
-        bool decode_messageframe;
-		bool decode_asdframe;
-        bool decode_functionality;
-
-		// TODO: flagword is more challenging here...
-        enum asn_transfer_syntax decode_1609dot2_type;
-        enum asn_transfer_syntax decode_messageframe_type;
-        enum asn_transfer_syntax decode_asdframe_type;
-        enum asn_transfer_syntax curr_decode_type_;
-    
-        uint32_t curr_op_;
-        std::string curr_node_path_;
-        pugi::xml_node payload_node_;
-
-        std::vector<std::tuple<uint32_t, enum asn_transfer_syntax, std::string, bool>> protocol_;
-        std::vector<std::tuple<std::string, std::string>> hex_data_;
+        bool bytes_to_hex_(const char* bytes, std::size_t size, std::string& payload_hex );
 
-        enum asn_transfer_syntax get_ats_transfer_syntax( const char* ats_type );
-        bool set_codec_requirements( pugi::xml_document& doc );
+        bool decode_functionality;                                      ///> The direction of the file tests and of the default pipeline.
 
-        bool decode_message( pugi::xml_node& payload_node, std::stringstream& output_message_stream );
-        bool decode_message_legacy( pugi::xml_node& payload_node, std::stringstream& output_message_stream );
-        bool decode_1609dot2_data( std::string& data_as_hex, buffer_structure_t* xml_buffer );
-        bool decode_messageframe_data( std::string& data_as_hex, buffer_structure_t* xml_buffer );
+        bool configure_pipelines();
+        bool configure_raw_input( Pipeline& pipeline, const std::string& prefix );
+        const Pipeline& pipeline_for( const RdKafka::Message* message ) const;
 
-        bool encode_message( std::stringstream& output_message_stream );
-        void encode_frame_data(const std::string& data_as_xml, std::string& hex_string);
-        void encode_node_as_hex_string(bool replace = true);
-        void encode_for_protocol();
+        enum asn_transfer_syntax get_ats_transfer_syntax( const char* ats_type );
+        bool set_codec_requirements( CodecContext& ctx );
+        bool set_raw_codec_requirements( CodecContext& ctx, RdKafka::Message* message, const Pipeline& pipeline );
+        void select_plan( CodecContext& ctx );
+        CodecPlan compile_plan( const std::string& plan_key );
+        void prepare_output( CodecContext& ctx, const void* input, std::size_t size ) const;
+        void write_output( CodecContext& ctx, pugi::xml_writer& output ) const;
+        void write_document( CodecContext& ctx, const pugi::xml_document& doc, pugi::xml_writer& output ) const;
+
+        bool decode_message( CodecContext& ctx, pugi::xml_node& payload_node, pugi::xml_writer& output );
+        bool decode_1609dot2_data( CodecContext& ctx, std::string& data_as_hex );
+        bool decode_1609dot2_bytes( CodecContext& ctx );
+        bool decode_raw_message( CodecContext& ctx, RdKafka::Message* message, const Pipeline& pipeline, pugi::xml_writer& output );
+        bool decode_messageframe_data( CodecContext& ctx, std::string& data_as_hex, pugi::xml_node& parent );
+        bool decode_messageframe_bytes( CodecContext& ctx, pugi::xml_node& parent );
+        void* decode_pdu( CodecContext& ctx, const asn_TYPE_descriptor_t* td, enum asn_transfer_syntax ats );
+        void free_pdu( CodecContext& ctx, const asn_TYPE_descriptor_t* td, void* pdu );
+
+        bool encode_message( CodecContext& ctx, pugi::xml_writer& output );
+        void encode_frame_data( CodecContext& ctx, const asn_TYPE_descriptor_t* data_struct, enum asn_transfer_syntax syntax, const std::string& data_as_xml, std::string& hex_string );
+        void encode_node_as_hex_string( CodecContext& ctx, const CodecPlan::EncodeStep& step );
+        void encode_for_protocol( CodecContext& ctx );
+
+        void init_codec_context( CodecContext& ctx ) const;
+        bool configure_affinity();
+        bool configure_constraints();
+        bool configure_projections();
+        bool configure_uper_skips();
+        bool configure_bsm_batches();
+        void collect_bsm( CodecContext& ctx, const asn_TYPE_descriptor_t* td, const void* pdu );
+        void flush_bsm_batch( CodecContext& ctx, bool force );
+        bool check_constraints( CodecContext& ctx, const asn_TYPE_descriptor_t* td, const void* sptr, bool encoding );
+        void pin_thread( const std::string& name, const affinity::CpuList& cpus );
+        OutputBuffer codec_message( CodecContext& ctx, RdKafka::Message* message );
+        void codec_worker( std::size_t index );
+        bool take_work( std::size_t index, std::unique_ptr<RdKafka::Message>& message );
+        void egress_worker();
+        void start_codec_workers();
+        void stop_codec_workers();
+        void dispatch_message( std::unique_ptr<RdKafka::Message>&& message );
+        void consume_batch( std::vector<std::unique_ptr<RdKafka::Message>>& batch );
+        void track_messages( const std::vector<std::unique_ptr<RdKafka::Message>>& batch );
+        void track_message( const std::string& topic, int32_t partition, int64_t offset );
+        void pause_partition( const PartitionKey& key, bool pause );
+        bool set_paused( const std::vector<PartitionKey>& keys, bool pause );
+        std::vector<std::string> missing_topics();
+        void drain_in_flight();
+        void drop_revoked_messages( std::vector<std::unique_ptr<RdKafka::Message>>& batch );
+        void partitions_assigned( std::vector<RdKafka::TopicPartition*>& partitions, bool incremental );
+        void partitions_revoked( std::vector<RdKafka::TopicPartition*>& partitions, bool incremental );
+        void complete_message( RdKafka::Message* message, OutputBuffer&& output );
+        void produce_output( OutputBuffer& output, RdKafka::Topic* topic );
+        bool produce_held_outputs();
+        bool produce_now( OutputBuffer& output, RdKafka::Topic* topic );
+        void store_offset( const PartitionKey& key, int64_t offset );
+        void drain_held_outputs();
+        void start_delivery_poller();
+        void stop_delivery_poller();
+        void pause_consumption( bool pause );
 
         std::string get_current_time() const;
 };
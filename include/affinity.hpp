@@ -0,0 +1,63 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#ifndef ACM_AFFINITY_H
+#define ACM_AFFINITY_H
+
+#include <string>
+#include <vector>
+
+namespace affinity {
+
+using CpuList = std::vector<int>;                                       ///< Alias for a sorted list of cpu ids.
+
+/**
+ * @brief Parse a Linux style cpu list, e.g., "2-15" or "0,2,4-7".
+ *
+ * @param list the cpu list.
+ * @param cpus the sorted, distinct cpu ids; only modified on success.
+ * @return true if the list is well formed and not empty; false otherwise.
+ */
+bool parse_cpu_list( const std::string& list, CpuList& cpus );
+
+/**
+ * @brief Find the cpus of a NUMA node using /sys/devices/system/node/node<N>/cpulist.
+ *
+ * @return true if the node exists and has cpus; false otherwise (including on systems without sysfs).
+ */
+bool numa_node_cpus( int node, CpuList& cpus );
+
+/**
+ * @brief The cpus that are in both lists.
+ */
+CpuList intersect( const CpuList& a, const CpuList& b );
+
+/**
+ * @brief Restrict the calling thread to the given cpus. Memory the thread touches first is then allocated by the kernel
+ * on the NUMA node of those cpus.
+ *
+ * @return true if the thread was pinned or cpus is empty; false if the system refused or does not support it.
+ */
+bool pin_current_thread( const CpuList& cpus );
+
+}  // end namespace.
+
+#endif
@@ -0,0 +1,88 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#ifndef ACM_ASN1_CBOR_H
+#define ACM_ASN1_CBOR_H
+
+#include "asn_application.h"
+#include "projection.hpp"
+#include "pugixml.hpp"
+
+#include <string>
+
+namespace asn1_cbor {
+
+/**
+ * @brief Write a decoded asn1c structure as CBOR (RFC 8949), walking it with its type descriptors.
+ *
+ * The CBOR has the shape of the JSON output: a SEQUENCE is a map of its present members, a CHOICE (or open type) a map
+ * with its one alternative, a SEQUENCE OF an array, integers and booleans are CBOR integers and simple values, and
+ * enumerations are their identifiers. OCTET STRINGs are byte strings copied straight from the structure; other leaves
+ * are text strings of the text XER would write, read from the structure for BIT STRINGs and the common character
+ * strings and written by the leaf's own XER encoder for the rest (e.g., REAL, OBJECT IDENTIFIER); see
+ * asn1_walk::leaf_text. Every map and array has a definite length.
+ *
+ * A writer keeps a scratch buffer between calls, so use one per thread (the codec context owns one).
+ */
+class Writer {
+    public:
+
+        Writer() :
+            scratch_{}
+            , failed_type_{ nullptr }
+        {}
+
+        /**
+         * @brief Append {"<XML tag of td>": <structure>} to out.
+         *
+         * @param projection the parts of the structure to write; nullptr writes all of it.
+         * @return false if a component cannot be written; failed_type() says which, and out is unspecified.
+         */
+        bool append( std::string& out, const asn_TYPE_descriptor_t* td, const void* sptr, const Projection* projection = nullptr );
+
+        /**
+         * @return the type that could not be written by the last failed append().
+         */
+        const asn_TYPE_descriptor_t* failed_type() const {
+            return failed_type_;
+        }
+
+    private:
+
+        friend class Encoder;
+
+        std::string scratch_;                                           ///< Leaf text that is not in the structure itself.
+        const asn_TYPE_descriptor_t* failed_type_;
+};
+
+/**
+ * @brief Write an XML document (the OdeAsn1Data envelope) as CBOR, with the same shape as asn1_json::write_document.
+ *
+ * @param doc the document to write.
+ * @param output receives the CBOR.
+ * @param raw_node an element written as raw_cbor instead of its content; may be empty.
+ * @param raw_cbor a complete CBOR data item, e.g., from Writer::append.
+ */
+void write_document( const pugi::xml_document& doc, pugi::xml_writer& output, pugi::xml_node raw_node = pugi::xml_node{}, const std::string& raw_cbor = std::string{} );
+
+}  // end namespace.
+
+#endif
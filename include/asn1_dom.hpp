@@ -0,0 +1,83 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#ifndef ACM_ASN1_DOM_H
+#define ACM_ASN1_DOM_H
+
+#include "asn_application.h"
+#include "projection.hpp"
+#include "pugixml.hpp"
+
+#include <string>
+
+namespace asn1_dom {
+
+/**
+ * @brief Build the XER form of a decoded asn1c structure directly as pugixml nodes.
+ *
+ * The structure is walked with its type descriptors, so the result is the same document that xer_encode with
+ * XER_F_CANONICAL would write, without writing that text and parsing it again. Constructed types, integers, enumerations
+ * and booleans are built node by node; any other type is written with its own XER encoder and only that small piece is
+ * parsed.
+ *
+ * A builder keeps a scratch buffer between calls, so use one per thread (the codec context owns one).
+ */
+class Builder {
+    public:
+
+        Builder() :
+            scratch_{}
+            , failed_type_{ nullptr }
+        {}
+
+        /**
+         * @brief Append the element for the structure (named with the type's XML tag) to parent.
+         *
+         * @param parent the node that receives the new element.
+         * @param td the type descriptor of the structure, e.g., &asn_DEF_MessageFrame.
+         * @param sptr the decoded structure.
+         * @param projection the parts of the structure to build; nullptr builds all of it.
+         * @return the new element, or an empty node on failure (nothing is left in parent); failed_type() then says why.
+         */
+        pugi::xml_node append( pugi::xml_node parent, const asn_TYPE_descriptor_t* td, const void* sptr, const Projection* projection = nullptr );
+
+        /**
+         * @return the type that could not be represented by the last failed append().
+         */
+        const asn_TYPE_descriptor_t* failed_type() const {
+            return failed_type_;
+        }
+
+    private:
+
+        bool fill( pugi::xml_node node, const asn_TYPE_descriptor_t* td, const void* sptr, const Projection* projection );
+        bool fill_member( pugi::xml_node node, const asn_TYPE_member_t& elm, const void* sptr, const Projection* projection );
+        bool fill_list( pugi::xml_node node, const asn_TYPE_descriptor_t* td, const void* sptr, const Projection* projection );
+        bool fill_encoded( pugi::xml_node node, const asn_TYPE_descriptor_t* td, const void* sptr );
+        bool fail( const asn_TYPE_descriptor_t* td );
+
+        std::string scratch_;                                           ///< Leaf XER written by the asn1c encoders.
+        const asn_TYPE_descriptor_t* failed_type_;
+};
+
+}  // end namespace.
+
+#endif
@@ -0,0 +1,68 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#ifndef ACM_ASN1_REGISTRY_H
+#define ACM_ASN1_REGISTRY_H
+
+#include "asn_application.h"
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+extern "C" {
+    // generated by asn1c -pdu=all in pdu_collection.c; the list ends with a null pointer.
+    extern struct asn_TYPE_descriptor_s *asn_pdu_collection[];
+}
+
+/**
+ * @brief Finds the asn1c type descriptor for an ASN.1 type name, e.g., the elementType of an encodings entry.
+ *
+ * The registry indexes every descriptor in a PDU collection by its ASN.1 name. When specifications are compiled
+ * together the names can collide; the type with the most elements wins, which picks the structured PDU over a same
+ * named field type (see docs/interface.md).
+ */
+class Asn1Registry {
+    public:
+
+        /**
+         * @param collection a null terminated list of descriptors, normally asn_pdu_collection.
+         */
+        explicit Asn1Registry( asn_TYPE_descriptor_t* const* collection );
+
+        /**
+         * @return the descriptor of the named type, or nullptr if there is no such PDU.
+         */
+        const asn_TYPE_descriptor_t* find( const std::string& name ) const {
+            auto it = types_.find( name );
+            return it == types_.end() ? nullptr : it->second;
+        }
+
+        std::size_t size() const {
+            return types_.size();
+        }
+
+    private:
+
+        std::unordered_map<std::string, const asn_TYPE_descriptor_t*> types_;
+};
+
+#endif
@@ -0,0 +1,229 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#ifndef ACM_ASN1_WALK_H
+#define ACM_ASN1_WALK_H
+
+#include "asn_application.h"
+#include "projection.hpp"
+#include "pugixml.hpp"
+
+#include "BOOLEAN.h"
+#include "NativeEnumerated.h"
+#include "NativeInteger.h"
+#include "NULL.h"
+#include "OPEN_TYPE.h"
+#include "asn_SEQUENCE_OF.h"
+#include "constr_CHOICE.h"
+#include "constr_SEQUENCE.h"
+#include "constr_SEQUENCE_OF.h"
+#include "constr_SET_OF.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * The pieces the DOM, JSON and CBOR writers share: walking a projection alongside a decoded structure, walking the
+ * structure itself for the JSON and CBOR writers, collecting leaf encoder output, and reading an XML envelope element
+ * by element.
+ */
+namespace asn1_walk {
+
+/**
+ * @brief Marks a part of the structure that is on no selected path; compare with &nothing.
+ */
+extern const Projection nothing;
+
+/**
+ * @brief The projection below a step: nullptr for everything, &nothing when the step is on no selected path.
+ */
+const Projection* step( const Projection* projection, const char* name );
+
+/**
+ * @brief The value of a member of a SEQUENCE or CHOICE, or nullptr if it is absent or on no selected path.
+ *
+ * A SEQUENCE OF member whose items are on no selected path is left out too, rather than written as an empty list.
+ *
+ * @param projection the projection at sptr; becomes the one at the member.
+ */
+const void* member_value( const asn_TYPE_member_t& elm, const void* sptr, const Projection*& projection );
+
+/**
+ * @brief The projection at the items of a SEQUENCE OF or SET OF; the items are a step of a projection's paths, named
+ * like their XML elements, except for lists of bare values.
+ */
+const Projection* list_step( const asn_TYPE_descriptor_t* td, const Projection* projection );
+
+/**
+ * @brief asn_app_consume_bytes_f that collects encoder output in the std::string app_key points to.
+ */
+int append_to_string( const void* buffer, size_t size, void* app_key );
+
+/**
+ * @brief Replace the escapes the asn1c string encoders write in XER character data by the characters, in place.
+ */
+void unescape( std::string& text );
+
+/**
+ * @brief The text of a leaf of the structure, as XER would write it.
+ */
+struct Leaf {
+    enum class Kind {
+        TEXT,                                                       ///< Character data.
+        NUMBER,                                                     ///< A decimal INTEGER.
+        IDENTIFIER                                                  ///< Written by XER as an empty element, e.g., an ENUMERATED value.
+    };
+
+    Kind kind;
+    const char* data;                                               ///< In the structure or in the scratch buffer; not terminated.
+    std::size_t size;
+};
+
+/**
+ * @brief Find the text of a leaf.
+ *
+ * OCTET STRINGs (hex), BIT STRINGs (a 0 or 1 for each bit), UTF8String, IA5String and VisibleString (their characters)
+ * and INTEGERs that fit a long are read straight from the structure. Any other leaf, e.g., a REAL, OBJECT IDENTIFIER,
+ * time, ENUMERATED, or INTEGER too large for a long, is written by its XER encoder and unescaped.
+ *
+ * @param scratch holds the text when it is not in the structure itself.
+ * @return nullptr, or the type the XER encoder could not write.
+ */
+const asn_TYPE_descriptor_t* leaf_text( const asn_TYPE_descriptor_t* td, const void* sptr, std::string& scratch, Leaf& leaf );
+
+/**
+ * @brief The names of node's child elements, each once, in order of first appearance; none if it has only text.
+ */
+void element_names( pugi::xml_node node, std::vector<const char*>& names );
+
+/**
+ * @brief Walks a decoded structure with its type descriptors, and the parts of it a projection selects, for a writer
+ * that only emits what the walk finds.
+ *
+ * A SEQUENCE becomes a map of its present members, a CHOICE (or open type) a map of its one alternative, and a
+ * SEQUENCE OF an array. The Emitter has:
+ *
+ * - static constexpr bool sized: whether start_map and start_array need the number of entries; otherwise 0 is passed.
+ * - start_map( size ), end_map(), start_array( size ), end_array(), and key( name ) for a map's keys.
+ * - integer( long ), unsigned_integer( unsigned long ), identifier( name ) for an ENUMERATED value, boolean( bool ),
+ *   and null().
+ * - leaf( td, sptr ) for any other leaf, e.g., with leaf_text.
+ * - fail( td ) for a value that cannot be written.
+ *
+ * Each returns false to stop the walk, and the walk returns false.
+ */
+template<typename Emitter>
+class Walker {
+    public:
+
+        explicit Walker( Emitter& emit ) :
+            emit_( emit )
+        {}
+
+        bool value( const asn_TYPE_descriptor_t* td, const void* sptr, const Projection* projection ) {
+            const asn_TYPE_operation_t* op = td->op;
+
+            if ( op == &asn_OP_SEQUENCE ) {
+                std::size_t size = 0;
+                for ( unsigned i = 0; Emitter::sized && i < td->elements_count; ++i ) {
+                    const Projection* below = projection;
+                    if ( member_value( td->elements[i], sptr, below ) ) ++size;
+                }
+
+                if ( !emit_.start_map( size ) ) return false;
+                for ( unsigned i = 0; i < td->elements_count; ++i ) {
+                    if ( !member( td->elements[i], sptr, projection ) ) return false;
+                }
+                return emit_.end_map();
+            }
+
+            if ( op == &asn_OP_CHOICE || op == &asn_OP_OPEN_TYPE ) {
+                unsigned present = CHOICE_variant_get_presence( td, sptr );
+                if ( present == 0 || present > td->elements_count ) return emit_.fail( td );
+
+                const asn_TYPE_member_t& elm = td->elements[ present - 1 ];
+                const Projection* below = projection;
+                if ( !emit_.start_map( Emitter::sized && member_value( elm, sptr, below ) ? 1 : 0 ) ) return false;
+                if ( !member( elm, sptr, projection ) ) return false;
+                return emit_.end_map();
+            }
+
+            if ( op == &asn_OP_SEQUENCE_OF || op == &asn_OP_SET_OF ) {
+                const asn_TYPE_member_t& elm = td->elements[0];
+                const asn_anonymous_sequence_* list = _A_CSEQUENCE_FROM_VOID( sptr );
+                projection = list_step( td, projection );
+
+                std::size_t size = 0;
+                for ( int i = 0; Emitter::sized && projection != &nothing && i < list->count; ++i ) {
+                    if ( list->array[i] ) ++size;
+                }
+
+                if ( !emit_.start_array( size ) ) return false;
+                for ( int i = 0; projection != &nothing && i < list->count; ++i ) {
+                    if ( list->array[i] && !value( elm.type, list->array[i], projection ) ) return false;
+                }
+                return emit_.end_array();
+            }
+
+            if ( op == &asn_OP_NativeInteger ) {
+                const asn_INTEGER_specifics_t* specs = static_cast<const asn_INTEGER_specifics_t*>( td->specifics );
+                long v = *static_cast<const long*>( sptr );
+
+                if ( specs && specs->field_unsigned ) return emit_.unsigned_integer( static_cast<unsigned long>( v ) );
+                return emit_.integer( v );
+            }
+
+            if ( op == &asn_OP_NativeEnumerated ) {
+                const asn_INTEGER_specifics_t* specs = static_cast<const asn_INTEGER_specifics_t*>( td->specifics );
+                const asn_INTEGER_enum_map_t* entry = INTEGER_map_value2enum( specs, *static_cast<const long*>( sptr ) );
+                if ( !entry ) return emit_.fail( td );
+
+                return emit_.identifier( entry->enum_name );
+            }
+
+            if ( op == &asn_OP_BOOLEAN ) {
+                return emit_.boolean( *static_cast<const BOOLEAN_t*>( sptr ) != 0 );
+            }
+
+            if ( op == &asn_OP_NULL ) {
+                return emit_.null();
+            }
+
+            return emit_.leaf( td, sptr );
+        }
+
+    private:
+
+        bool member( const asn_TYPE_member_t& elm, const void* sptr, const Projection* projection ) {
+            const void* mptr = member_value( elm, sptr, projection );
+            if ( !mptr ) return true;
+
+            if ( !emit_.key( elm.name ) ) return false;
+            return value( elm.type, mptr, projection );
+        }
+
+        Emitter& emit_;
+};
+
+}  // end namespace.
+
+#endif
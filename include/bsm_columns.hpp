@@ -0,0 +1,101 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#ifndef ACM_BSM_COLUMNS_H
+#define ACM_BSM_COLUMNS_H
+
+#include "BSMcoreData.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief BSM coreData fields gathered column by column (struct of arrays) for analytics that scan many BSMs at once.
+ *
+ * write() lays a batch out as a small self-describing columnar file, all integers little-endian:
+ *
+ * - the magic "ACMBSMC1", the row count (uint32), and the column count (uint32);
+ * - per column: its name length (uint8) and name, a type code (uint8: the Python struct / numpy character of the
+ *   values: 'B' uint8, 'b' int8, 'H' uint16, 'h' int16, 'I' uint32, 'i' int32), zero padding to a multiple of 8 bytes,
+ *   then the packed values, padded again to a multiple of 8 bytes.
+ *
+ * Every column is 8 byte aligned in the file, so a reader can map it without copying (e.g., numpy.frombuffer). The
+ * values are the J2735 units, e.g., lat in 1/10 micro degrees; id is the 4 octets of the TemporaryID as a big-endian
+ * number, and wheelBrakes is its 5 bits with the first (unavailable) the most significant.
+ */
+class BsmBatch {
+    public:
+
+        BsmBatch();
+
+        void append( const BSMcoreData_t& core );
+
+        std::size_t rows() const {
+            return msg_cnt_.size();
+        }
+
+        bool empty() const {
+            return msg_cnt_.empty();
+        }
+
+        /**
+         * @return when the first row of the batch was appended.
+         */
+        std::chrono::steady_clock::time_point started() const {
+            return started_;
+        }
+
+        /**
+         * @brief Replace out with the batch in the columnar layout above.
+         */
+        void write( std::string& out ) const;
+
+        /**
+         * @brief Remove every row; the columns keep their memory for the next batch.
+         */
+        void clear();
+
+    private:
+
+        std::chrono::steady_clock::time_point started_;
+        std::vector<uint32_t> id_;
+        std::vector<uint8_t> msg_cnt_;
+        std::vector<uint16_t> sec_mark_;
+        std::vector<int32_t> lat_;
+        std::vector<int32_t> long_;
+        std::vector<int32_t> elev_;
+        std::vector<uint16_t> speed_;
+        std::vector<uint16_t> heading_;
+        std::vector<int16_t> accel_long_;
+        std::vector<int16_t> accel_lat_;
+        std::vector<int8_t> accel_vert_;
+        std::vector<int16_t> accel_yaw_;
+        std::vector<uint8_t> wheel_brakes_;
+        std::vector<uint8_t> traction_;
+        std::vector<uint8_t> abs_;
+        std::vector<uint8_t> scs_;
+        std::vector<uint8_t> brake_boost_;
+        std::vector<uint8_t> aux_brakes_;
+};
+
+#endif
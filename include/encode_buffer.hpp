@@ -0,0 +1,135 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#ifndef ACM_ENCODE_BUFFER_H
+#define ACM_ENCODE_BUFFER_H
+
+#include "asn_application.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <unordered_map>
+
+/**
+ * @brief The buffer an asn1c encoder writes into, kept by a codec worker across messages.
+ *
+ * The memory is never given back, so once the worker has seen its largest message encoding allocates nothing. Before
+ * each encoding the buffer is also sized from a running average of what that type has encoded to (plus headroom), so a
+ * new or larger type grows it once instead of doubling through several copies. The memory comes from realloc, so
+ * growing it neither zero fills nor copies more than the bytes in use.
+ */
+class EncodeBuffer {
+    public:
+
+        EncodeBuffer() :
+            bytes_{ nullptr }
+            , size_{ 0 }
+            , capacity_{ 0 }
+            , estimates_{}
+        {}
+
+        EncodeBuffer( const EncodeBuffer& ) = delete;
+        EncodeBuffer& operator=( const EncodeBuffer& ) = delete;
+
+        ~EncodeBuffer() {
+            std::free( bytes_ );
+        }
+
+        /**
+         * @brief Empty the buffer and make room for an encoding of type td.
+         */
+        void prepare( const asn_TYPE_descriptor_t* td ) {
+            size_ = 0;
+
+            auto it = estimates_.find( td );
+            std::size_t estimate = it == estimates_.end() ? initial_size : it->second + it->second / 2;
+            if ( !reserve( estimate ) ) throw std::bad_alloc{};
+        }
+
+        /**
+         * @brief Record the size of the finished encoding of type td; the estimate moves 1/4 of the way toward it.
+         */
+        void finish( const asn_TYPE_descriptor_t* td ) {
+            auto it = estimates_.find( td );
+            if ( it == estimates_.end() ) {
+                estimates_.emplace( td, size_ );
+            } else if ( size_ >= it->second ) {
+                it->second += ( size_ - it->second ) / 4;
+            } else {
+                it->second -= ( it->second - size_ ) / 4;
+            }
+        }
+
+        /**
+         * @brief An asn_app_consume_bytes_f; app_key is the EncodeBuffer. It is called from the C encoders, so running
+         * out of memory returns -1, which fails the encoding, instead of throwing.
+         */
+        static int append( const void* buffer, size_t size, void* app_key ) {
+            EncodeBuffer* eb = static_cast<EncodeBuffer*>( app_key );
+
+            if ( size > std::numeric_limits<std::size_t>::max() / 2 - eb->size_ ) return -1;
+            if ( eb->size_ + size > eb->capacity_ && !eb->reserve( 2 * ( eb->size_ + size ) ) ) return -1;
+
+            if ( size > 0 ) std::memcpy( eb->bytes_ + eb->size_, buffer, size );
+            eb->size_ += size;
+            return 0;
+        }
+
+        const char* data() const {
+            return bytes_;
+        }
+
+        std::size_t size() const {
+            return size_;
+        }
+
+        std::size_t capacity() const {
+            return capacity_;
+        }
+
+    private:
+
+        static constexpr std::size_t initial_size = 256;
+
+        /**
+         * @return false if the memory could not be had; the buffer is then unchanged.
+         */
+        bool reserve( std::size_t capacity ) {
+            if ( capacity <= capacity_ ) return true;
+
+            char* p = static_cast<char*>( std::realloc( bytes_, capacity ) );
+            if ( !p ) return false;
+
+            bytes_ = p;
+            capacity_ = capacity;
+            return true;
+        }
+
+        char* bytes_;                                                   ///< Only size_ of its capacity_ bytes are used.
+        std::size_t size_;
+        std::size_t capacity_;
+        std::unordered_map<const asn_TYPE_descriptor_t*, std::size_t> estimates_;   ///< Encoded bytes by type.
+};
+
+#endif
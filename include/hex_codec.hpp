@@ -0,0 +1,66 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#ifndef ACM_HEX_CODEC_H
+#define ACM_HEX_CODEC_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * Hex string conversion for the payloads the ODE sends and receives.
+ *
+ * On x86 the kernels use AVX2 or SSE4.1 when the cpu has them (checked once, at run time) and a table-driven scalar loop
+ * otherwise; every version gives the same result.
+ */
+namespace hex_codec {
+
+/**
+ * @brief Convert a hex string to bytes, skipping whitespace, and append them to bytes.
+ *
+ * Digits may be upper or lower case. An odd digit count leaves the last byte with only its high nibble set.
+ *
+ * @return false if the string has a character that is neither a hex digit nor whitespace; bytes is then unspecified.
+ */
+bool decode( const char* hex, std::size_t size, std::vector<char>& bytes );
+
+/**
+ * @brief decode(), also reporting how many of the characters the vector kernels converted.
+ *
+ * Whitespace and an odd run of digits are taken by the scalar loop only until the next digit pair, so a few spaces do
+ * not keep the rest of a string off the vector path.
+ */
+bool decode( const char* hex, std::size_t size, std::vector<char>& bytes, std::size_t& vectorized );
+
+/**
+ * @brief Replace the contents of hex with the upper case hex form of the bytes.
+ */
+void encode( const char* bytes, std::size_t size, std::string& hex );
+
+/**
+ * @brief The kernels in use: "avx2", "sse4.1", or "scalar".
+ */
+const char* kernel_name();
+
+}  // end namespace.
+
+#endif
@@ -0,0 +1,133 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#ifndef ACM_OUTPUT_BUFFER_H
+#define ACM_OUTPUT_BUFFER_H
+
+#include "pugixml.hpp"
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+/**
+ * @brief A growable heap buffer that holds one output message.
+ *
+ * pugixml serializes directly into it (it is an xml_writer), and the memory comes from malloc so the finished buffer
+ * can be handed to librdkafka with RK_MSG_FREE, which frees it after delivery. The output is therefore written once and
+ * never copied.
+ */
+class OutputBuffer : public pugi::xml_writer {
+    public:
+
+        OutputBuffer() :
+            data_{ nullptr }
+            , size_{ 0 }
+            , capacity_{ 0 }
+        {}
+
+        OutputBuffer( const OutputBuffer& ) = delete;
+        OutputBuffer& operator=( const OutputBuffer& ) = delete;
+
+        OutputBuffer( OutputBuffer&& other ) :
+            data_{ other.data_ }
+            , size_{ other.size_ }
+            , capacity_{ other.capacity_ }
+        {
+            other.data_ = nullptr;
+            other.size_ = other.capacity_ = 0;
+        }
+
+        OutputBuffer& operator=( OutputBuffer&& other ) {
+            if ( this != &other ) {
+                std::free( data_ );
+                data_ = other.data_;
+                size_ = other.size_;
+                capacity_ = other.capacity_;
+                other.data_ = nullptr;
+                other.size_ = other.capacity_ = 0;
+            }
+            return *this;
+        }
+
+        ~OutputBuffer() {
+            std::free( data_ );
+        }
+
+        void write( const void* data, std::size_t size ) override {
+            if ( size == 0 ) return;
+
+            if ( size_ + size > capacity_ ) {
+                reserve( 2 * ( size_ + size ) );
+            }
+            std::memcpy( data_ + size_, data, size );
+            size_ += size;
+        }
+
+        void append( const char* s ) {
+            write( s, std::strlen( s ) );
+        }
+
+        void reserve( std::size_t capacity ) {
+            if ( capacity <= capacity_ ) return;
+
+            char* p = static_cast<char*>( std::realloc( data_, capacity ) );
+            if ( !p ) throw std::bad_alloc{};
+
+            data_ = p;
+            capacity_ = capacity;
+        }
+
+        /**
+         * @brief Give up ownership of the memory; the caller must free() it (librdkafka does with RK_MSG_FREE).
+         */
+        char* release() {
+            char* p = data_;
+            data_ = nullptr;
+            size_ = capacity_ = 0;
+            return p;
+        }
+
+        void clear() {
+            size_ = 0;
+        }
+
+        char* data() const {
+            return data_;
+        }
+
+        std::size_t size() const {
+            return size_;
+        }
+
+        bool empty() const {
+            return size_ == 0;
+        }
+
+    private:
+
+        char* data_;
+        std::size_t size_;
+        std::size_t capacity_;
+};
+
+#endif
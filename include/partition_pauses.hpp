@@ -0,0 +1,144 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#ifndef ACM_PARTITION_PAUSES_H
+#define ACM_PARTITION_PAUSES_H
+
+#include <algorithm>
+#include <mutex>
+#include <set>
+#include <vector>
+
+/**
+ * @brief Reconciles the two reasons a consumer's partitions are paused: one partition's own backlog, and producer
+ * backpressure, which pauses them all.
+ *
+ * A partition resumes only when neither reason holds: resuming all skips the partitions still paused for their
+ * backlog, and a partition whose backlog clears while all are paused stays paused until they all resume. The changes
+ * themselves are made by the apply function, apply( keys, pause ), which returns false if the consumer refused them;
+ * it is called under the lock so the consumer sees the changes in the order they were decided.
+ *
+ * The per-partition and the global changes may come from different threads.
+ */
+template<typename Key>
+class PartitionPauses {
+    public:
+
+        PartitionPauses() :
+            all_paused_{ false }
+        {}
+
+        /**
+         * @brief Pause a partition for its own backlog.
+         *
+         * @return true if it was paused; false if it already was, or apply failed.
+         */
+        template<typename Apply>
+        bool pause( const Key& key, Apply apply ) {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+
+            if ( paused_.count( key ) > 0 ) return false;
+            if ( !apply( std::vector<Key>{ key }, true ) ) return false;
+
+            paused_.insert( key );
+            return true;
+        }
+
+        /**
+         * @brief Lift a partition's pause for its backlog; while all partitions are paused it is left to set_all.
+         *
+         * @return true if its backlog pause was lifted; false if it had none, or apply failed.
+         */
+        template<typename Apply>
+        bool resume( const Key& key, Apply apply ) {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+
+            if ( paused_.count( key ) == 0 ) return false;
+            if ( !all_paused_ && !apply( std::vector<Key>{ key }, false ) ) return false;
+
+            paused_.erase( key );
+            return true;
+        }
+
+        /**
+         * @brief Pause or resume every assigned partition; a resume leaves out those paused for their backlog.
+         *
+         * @return the number of partitions passed to apply, or -1 if apply failed.
+         */
+        template<typename Apply>
+        int set_all( std::vector<Key> assigned, bool pause, Apply apply ) {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+
+            if ( !pause ) {
+                assigned.erase( std::remove_if( assigned.begin(), assigned.end(),
+                            [this]( const Key& key ) { return paused_.count( key ) > 0; } ), assigned.end() );
+            }
+
+            if ( !apply( assigned, pause ) ) return -1;
+
+            all_paused_ = pause;
+            return static_cast<int>( assigned.size() );
+        }
+
+        bool paused( const Key& key ) const {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            return paused_.count( key ) > 0;
+        }
+
+        bool all_paused() const {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            return all_paused_;
+        }
+
+        /**
+         * @brief Forget a partition's backlog pause, e.g., when it is revoked.
+         */
+        void erase( const Key& key ) {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            paused_.erase( key );
+        }
+
+        /**
+         * @brief Forget every partition's backlog pause, e.g., when the eager protocol revokes them all; a pause for
+         * backpressure stays, so newly assigned partitions start paused.
+         */
+        void clear_partitions() {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            paused_.clear();
+        }
+
+        /**
+         * @brief Forget every pause, e.g., at the end of a consumer session.
+         */
+        void clear() {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            paused_.clear();
+            all_paused_ = false;
+        }
+
+    private:
+
+        mutable std::mutex mutex_;
+        std::set<Key> paused_;                                          ///< Paused for their own backlog.
+        bool all_paused_;                                               ///< Paused for producer backpressure.
+};
+
+#endif
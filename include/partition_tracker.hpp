@@ -0,0 +1,118 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#ifndef ACM_PARTITION_TRACKER_H
+#define ACM_PARTITION_TRACKER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+/**
+ * @brief Tracks the messages of one Kafka partition that are being processed in parallel.
+ *
+ * Offsets are registered with track() in the order they are consumed and finished with complete() in any order. The
+ * tracker decides which results may be published (in input order, or as soon as they finish) and the offset that may
+ * be committed: one past the highest offset for which it and every earlier offset have finished. That offset is safe
+ * to commit only once every result released up to it has been published, which the owner has to wait for.
+ *
+ * This class is not thread safe; the owner serializes access.
+ */
+template<typename T>
+class PartitionTracker {
+    public:
+
+        explicit PartitionTracker( bool ordered = true ) :
+            ordered_{ ordered }
+            , committable_{ -1 }
+        {}
+
+        /**
+         * @brief Register a consumed offset. Offsets must be registered in increasing order.
+         */
+        void track( int64_t offset ) {
+            slots_.push_back( Slot{ offset, false, T{} } );
+        }
+
+        /**
+         * @brief Record that the message at offset has finished with the given result.
+         *
+         * @param offset the offset of a message previously registered with track().
+         * @param result the output of the message; moved into ready when it may be published.
+         * @param ready results that may now be published are appended here in the order they must be published.
+         * @return true if the committable offset advanced.
+         */
+        bool complete( int64_t offset, T&& result, std::vector<T>& ready ) {
+            auto it = std::lower_bound( slots_.begin(), slots_.end(), offset,
+                    []( const Slot& slot, int64_t o ) { return slot.offset < o; } );
+
+            if ( it == slots_.end() || it->offset != offset || it->done ) return false;
+
+            it->done = true;
+            if ( ordered_ ) {
+                it->result = std::move( result );
+            } else {
+                ready.push_back( std::move( result ) );
+            }
+
+            bool advanced = false;
+            while ( !slots_.empty() && slots_.front().done ) {
+                if ( ordered_ ) {
+                    ready.push_back( std::move( slots_.front().result ) );
+                }
+                committable_ = slots_.front().offset + 1;
+                slots_.pop_front();
+                advanced = true;
+            }
+
+            return advanced;
+        }
+
+        /**
+         * @return the offset to commit once the released results are published (one past the last contiguous finished
+         * offset), or -1 if nothing has finished.
+         */
+        int64_t committable() const {
+            return committable_;
+        }
+
+        /**
+         * @return the number of tracked messages that have not been released yet.
+         */
+        std::size_t in_flight() const {
+            return slots_.size();
+        }
+
+    private:
+
+        struct Slot {
+            int64_t offset;
+            bool done;
+            T result;                                                   ///< Held here until earlier offsets finish (ordered only).
+        };
+
+        bool ordered_;                                                  ///< Publish in input order; otherwise in completion order.
+        int64_t committable_;
+        std::deque<Slot> slots_;
+};
+
+#endif
@@ -0,0 +1,74 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#ifndef ACM_PROJECTION_H
+#define ACM_PROJECTION_H
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief The parts of a decoded PDU to write: a set of paths (e.g., value/BasicSafetyMessage/coreData) kept as a tree.
+ *
+ * Path steps are the element names of the XML output below the PDU's own element; an item of a SEQUENCE OF is a step
+ * named like its XML element. A node at the end of a path selects its whole subtree; the writers skip every member that
+ * is on no path, so unselected parts are never written.
+ */
+class Projection {
+    public:
+
+        Projection() :
+            children_{}
+            , whole_{ false }
+        {}
+
+        /**
+         * @brief Select the subtree at a '/' separated path.
+         *
+         * @return false if the path is empty or has an empty step; the projection is unchanged.
+         */
+        bool add( const std::string& path );
+
+        /**
+         * @return the projection below the named step, or nullptr if nothing below it is selected.
+         */
+        const Projection* child( const char* name ) const;
+
+        /**
+         * @return true if everything below this node is selected.
+         */
+        bool whole() const {
+            return whole_;
+        }
+
+        bool empty() const {
+            return !whole_ && children_.empty();
+        }
+
+    private:
+
+        std::vector<std::pair<std::string, std::unique_ptr<Projection>>> children_;   ///< Few steps each; searched in order.
+        bool whole_;
+};
+
+#endif
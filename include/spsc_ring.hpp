@@ -0,0 +1,162 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#ifndef ACM_SPSC_RING_H
+#define ACM_SPSC_RING_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A bounded, lock-free ring buffer for exactly one producer thread and one consumer thread; the pipeline stages
+ * are connected with these.
+ *
+ * The capacity is rounded up to a power of two. Each side keeps a cached copy of the other side's index, so the shared
+ * indices are only read when the ring looks full (producer) or empty (consumer). Neither operation blocks; a stage that
+ * cannot make progress waits with a Backoff.
+ */
+template<typename T>
+class SpscRing {
+    public:
+
+        explicit SpscRing( std::size_t capacity ) :
+            mask_{ round_up( capacity ) - 1 }
+            , slots_( mask_ + 1 )
+            , pad0_{}
+            , head_{ 0 }
+            , tail_cache_{ 0 }
+            , pad1_{}
+            , tail_{ 0 }
+            , head_cache_{ 0 }
+            , pad2_{}
+        {}
+
+        SpscRing( const SpscRing& ) = delete;
+        SpscRing& operator=( const SpscRing& ) = delete;
+
+        /**
+         * @brief Producer side.
+         *
+         * @return true if the item was added; false if the ring is full, in which case item is left untouched.
+         */
+        bool try_push( T&& item ) {
+            std::size_t tail = tail_.load( std::memory_order_relaxed );
+
+            if ( tail - head_cache_ > mask_ ) {
+                head_cache_ = head_.load( std::memory_order_acquire );
+                if ( tail - head_cache_ > mask_ ) return false;
+            }
+
+            slots_[ tail & mask_ ] = std::move( item );
+            tail_.store( tail + 1, std::memory_order_release );
+            return true;
+        }
+
+        /**
+         * @brief Consumer side.
+         *
+         * @return true if an item was removed into item; false if the ring is empty.
+         */
+        bool try_pop( T& item ) {
+            std::size_t head = head_.load( std::memory_order_relaxed );
+
+            if ( head == tail_cache_ ) {
+                tail_cache_ = tail_.load( std::memory_order_acquire );
+                if ( head == tail_cache_ ) return false;
+            }
+
+            item = std::move( slots_[ head & mask_ ] );
+            head_.store( head + 1, std::memory_order_release );
+            return true;
+        }
+
+        /**
+         * @return true if the ring held no items at the time of the call; exact only when the other side is idle.
+         */
+        bool empty() const {
+            return head_.load( std::memory_order_acquire ) == tail_.load( std::memory_order_acquire );
+        }
+
+        std::size_t capacity() const {
+            return mask_ + 1;
+        }
+
+    private:
+
+        static constexpr std::size_t cache_line = 64;
+
+        static std::size_t round_up( std::size_t n ) {
+            std::size_t p = 1;
+            while ( p < n ) p <<= 1;
+            return p;
+        }
+
+        const std::size_t mask_;
+        std::vector<T> slots_;
+
+        // the padding keeps each side's index and cache on its own cache line (without needing aligned new).
+        char pad0_[ cache_line ];
+
+        std::atomic<std::size_t> head_;                                 ///< Next slot to read.
+        std::size_t tail_cache_;                                        ///< The consumer's last view of tail_.
+        char pad1_[ cache_line ];
+
+        std::atomic<std::size_t> tail_;                                 ///< Next slot to write.
+        std::size_t head_cache_;                                        ///< The producer's last view of head_.
+        char pad2_[ cache_line ];
+};
+
+/**
+ * @brief How a pipeline stage waits when its ring is full or empty: spin briefly, then yield, then sleep, so an idle
+ * stage costs almost no CPU and a busy one reacts without a context switch.
+ */
+class Backoff {
+    public:
+
+        Backoff() : count_{ 0 } {}
+
+        void pause() {
+            if ( count_ < spin_limit ) {
+                ++count_;
+            } else if ( count_ < yield_limit ) {
+                ++count_;
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for( std::chrono::microseconds( 100 ) );
+            }
+        }
+
+        void reset() {
+            count_ = 0;
+        }
+
+    private:
+
+        static constexpr unsigned spin_limit = 64;
+        static constexpr unsigned yield_limit = 128;
+
+        unsigned count_;
+};
+
+#endif
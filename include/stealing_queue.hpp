@@ -0,0 +1,147 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#ifndef ACM_STEALING_QUEUE_H
+#define ACM_STEALING_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @brief A codec worker's bounded, lock-free run queue: one producer (the ingest stage) and any number of consumers
+ * (the owning worker and idle workers stealing from it).
+ *
+ * Every slot carries a sequence number that says whether it is ready to be written or read in the current lap, so
+ * consumers claim an item with a single compare-and-swap on the head and the producer never takes a lock. Items are
+ * taken in FIFO order by owner and thieves alike, which keeps the oldest work moving first.
+ */
+template<typename T>
+class StealingQueue {
+    public:
+
+        explicit StealingQueue( std::size_t capacity ) :
+            mask_{ round_up( capacity ) - 1 }
+            , cells_{ new Cell[ mask_ + 1 ] }
+            , pad0_{}
+            , head_{ 0 }
+            , pad1_{}
+            , tail_{ 0 }
+            , pad2_{}
+        {
+            for ( std::size_t i = 0; i <= mask_; ++i ) {
+                cells_[i].sequence.store( i, std::memory_order_relaxed );
+            }
+        }
+
+        StealingQueue( const StealingQueue& ) = delete;
+        StealingQueue& operator=( const StealingQueue& ) = delete;
+
+        /**
+         * @brief Producer side; only one thread may push.
+         *
+         * @return true if the item was added; false if the queue is full, in which case item is left untouched.
+         */
+        bool try_push( T&& item ) {
+            std::size_t pos = tail_.load( std::memory_order_relaxed );
+            Cell& cell = cells_[ pos & mask_ ];
+
+            // the slot still holds (or is being read for) the item from the previous lap.
+            if ( cell.sequence.load( std::memory_order_acquire ) != pos ) return false;
+
+            cell.value = std::move( item );
+            cell.sequence.store( pos + 1, std::memory_order_release );
+            tail_.store( pos + 1, std::memory_order_relaxed );
+            return true;
+        }
+
+        /**
+         * @brief Consumer side; safe for the owner and any number of thieves at once.
+         *
+         * @return true if an item was removed into item; false if the queue is empty.
+         */
+        bool try_pop( T& item ) {
+            std::size_t pos = head_.load( std::memory_order_relaxed );
+
+            while ( true ) {
+                Cell& cell = cells_[ pos & mask_ ];
+                std::size_t seq = cell.sequence.load( std::memory_order_acquire );
+                std::intptr_t diff = static_cast<std::intptr_t>( seq ) - static_cast<std::intptr_t>( pos + 1 );
+
+                if ( diff == 0 ) {
+                    if ( head_.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) ) {
+                        item = std::move( cell.value );
+                        cell.sequence.store( pos + mask_ + 1, std::memory_order_release );
+                        return true;
+                    }
+                    // pos was reloaded by the failed exchange.
+                } else if ( diff < 0 ) {
+                    return false;
+                } else {
+                    pos = head_.load( std::memory_order_relaxed );
+                }
+            }
+        }
+
+        /**
+         * @return the number of queued items; approximate while other threads are using the queue.
+         */
+        std::size_t size() const {
+            std::size_t head = head_.load( std::memory_order_acquire );
+            std::size_t tail = tail_.load( std::memory_order_acquire );
+            return tail > head ? tail - head : 0;
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+
+        std::size_t capacity() const {
+            return mask_ + 1;
+        }
+
+    private:
+
+        static constexpr std::size_t cache_line = 64;
+
+        static std::size_t round_up( std::size_t n ) {
+            std::size_t p = 1;
+            while ( p < n ) p <<= 1;
+            return p;
+        }
+
+        struct Cell {
+            std::atomic<std::size_t> sequence;                          ///< pos: free for the push at pos; pos + 1: holds that item.
+            T value;
+        };
+
+        const std::size_t mask_;
+        std::unique_ptr<Cell[]> cells_;
+
+        char pad0_[ cache_line ];
+        std::atomic<std::size_t> head_;                                 ///< Next position to take; shared by all consumers.
+        char pad1_[ cache_line ];
+        std::atomic<std::size_t> tail_;                                 ///< Next position to fill; producer only.
+        char pad2_[ cache_line ];
+};
+
+#endif
@@ -0,0 +1,73 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#ifndef ACM_UPER_SKIP_H
+#define ACM_UPER_SKIP_H
+
+#include "asn_application.h"
+#include "per_support.h"
+
+#include <string>
+
+/**
+ * @brief Components the UPER decoder steps over instead of decoding.
+ *
+ * A skipped member's descriptor is replaced by a copy whose UPER decoder walks the encoding with the original
+ * descriptors and only moves the bit cursor: lengths and presence bits are read, while open types, extensions and
+ * length prefixed integers are passed over by their length determinants without looking at their content. Nothing is
+ * allocated and the member is left absent, so it is missing from the decoded structure and from every output written
+ * from it. Only the few leaf types whose PER encoding has to be parsed (e.g., size constrained strings) are decoded and
+ * freed right away.
+ *
+ * Only OPTIONAL members can be skipped, since an absent value must still be a valid structure. The replacement
+ * changes the type descriptors themselves, so it applies to every decoder in the process and must be made before
+ * any decoding starts; the other encoding rules are unaffected.
+ */
+namespace uper_skip {
+
+/**
+ * @brief Skip the member at a '/' separated path below a type, e.g., partII below BasicSafetyMessage.
+ *
+ * The steps are the member names, as in the XML output (an item of a SEQUENCE OF is a step named like its element).
+ *
+ * @param td the type the path starts at.
+ * @param path the member to skip; it must be an OPTIONAL member of a SEQUENCE.
+ * @param error set to the reason when the member cannot be skipped.
+ * @return true if the member is skipped from now on.
+ */
+bool skip_member( const asn_TYPE_descriptor_t* td, const std::string& path, std::string& error );
+
+/**
+ * @brief Decode every skipped member again.
+ */
+void restore();
+
+/**
+ * @brief Move the cursor past one UPER encoded value of a type without keeping it.
+ *
+ * @param constraints the PER constraints of the value's member, or nullptr to use the type's own.
+ * @return true if the value was passed over; false if the encoding is malformed or truncated.
+ */
+bool skip_value( const asn_codec_ctx_t* opt_codec_ctx, const asn_TYPE_descriptor_t* td, const asn_per_constraints_t* constraints, asn_per_data_t* pd );
+
+}  // end namespace.
+
+#endif
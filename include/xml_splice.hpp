@@ -0,0 +1,93 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#ifndef ACM_XML_SPLICE_H
+#define ACM_XML_SPLICE_H
+
+#include "pugixml.hpp"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Writes a modified document by copying the original input text and replacing only the content of selected
+ * elements.
+ *
+ * The codec only changes a few elements of the input (the payload data and its dataType), so serializing the whole
+ * document again costs time in proportion to parts that never change. Instead, the elements that will change are
+ * located in the input text with replace_content() right after parsing, before any modification, and write() copies
+ * everything else verbatim.
+ *
+ * If an element cannot be located exactly (e.g., the input was converted from another encoding while parsing) the
+ * splice becomes invalid and the caller should save the document the usual way.
+ */
+class XmlSplice {
+    public:
+
+        XmlSplice() :
+            input_{ nullptr }
+            , size_{ 0 }
+            , valid_{ false }
+            , splices_{}
+        {}
+
+        /**
+         * @brief Start over with a new input; the input must stay unchanged and alive until write().
+         */
+        void reset( const char* input, std::size_t size );
+
+        /**
+         * @brief Mark an element whose content will be written from the document instead of the input.
+         *
+         * @param element an element of the document parsed from the input; it must not have been modified yet.
+         * @return true if the content was located in the input; false otherwise, which invalidates the splice.
+         */
+        bool replace_content( pugi::xml_node element );
+
+        /**
+         * @return true if write() will produce the document.
+         */
+        bool valid() const {
+            return valid_ && !splices_.empty();
+        }
+
+        /**
+         * @brief Write the input with the content of every marked element replaced by its current children.
+         */
+        void write( pugi::xml_writer& output ) const;
+
+    private:
+
+        struct Splice {
+            std::size_t begin;                                          ///< First input byte after the start tag.
+            std::size_t end;                                            ///< Input offset of the end tag.
+            pugi::xml_node element;
+        };
+
+        bool find_content( pugi::xml_node element, std::size_t& begin, std::size_t& end ) const;
+
+        const char* input_;
+        std::size_t size_;
+        bool valid_;
+        std::vector<Splice> splices_;                                   ///< Sorted by position, not overlapping.
+};
+
+#endif
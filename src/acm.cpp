@@ -45,6 +45,7 @@
 
 #include "acm.hpp"
 #include "utilities.hpp"
+#include "librdkafka/rdkafka.h"
 #include <iomanip>
 
 #include "spdlog/spdlog.h"
@@ -53,6 +54,7 @@
 #include <chrono>
 #include <thread>
 #include <cstdio>
+#include <cstring>
 
 // for both windows and linux.
 #include <sys/types.h>
@@ -106,34 +108,7 @@ bool dirExists( const std::string& s ) {
     return false;
 }
 
-/**
- *
- * TODO: Consider moving these to the ASN1_Codec class?
- */
-static int dynamic_buffer_append(const void *buffer, size_t size, void *app_key) {
-    buffer_structure_t *xb = static_cast<buffer_structure_t *>(app_key);
-
-    while(xb->buffer_size + size + 1 > xb->allocated_size) {
-        // increase size of buffer.
-        size_t new_size = 2 * (xb->allocated_size ? xb->allocated_size : 64);
-        char *new_buf = static_cast<char *>(MALLOC(new_size));
-        if(!new_buf) return -1;
-        // move old to new.
-        memcpy(new_buf, xb->buffer, xb->buffer_size);
-
-        FREEMEM(xb->buffer);
-        xb->buffer = new_buf;
-        xb->allocated_size = new_size;
-    }
-
-    memcpy(xb->buffer + xb->buffer_size, buffer, size);
-    xb->buffer_size += size;
-    // null terminate the string.
-    xb->buffer[xb->buffer_size] = '\0';
-    return 0;
-}
-
-bool ASN1_Codec::data_available = true;
+std::atomic<bool> ASN1_Codec::data_available{ true };
 bool ASN1_Codec::bootstrap = true;
 
 const char* asn1errortypes[] = {
@@ -160,6 +135,59 @@ std::ostream& operator<<( std::ostream& os, Asn1DataType dt ) {
 	return os;
 }
 
+CodecContext::CodecContext() :
+    input_doc{}
+    , internal_doc{}
+    , error_doc{}
+    , erroross{}
+    , byte_buffer{}
+    , dom_builder{}
+    , output_splice{}
+    , json_writer{}
+    , cbor_writer{}
+    , encoded_payload{}
+    , encoded_payload_node{}
+    , encode_buffer{}
+    , arena{ nullptr }
+    , errlen{ max_errbuf_size }
+    , opsflag{0}
+    , decode_1609dot2{ false }
+    , decode_messageframe{ false }
+    , decode_asdframe{ false }
+    , decode_1609dot2_type{ATS_CANONICAL_OER}
+    , decode_messageframe_type{ATS_UNALIGNED_BASIC_PER}
+    , decode_asdframe_type{ATS_UNALIGNED_BASIC_PER}
+    , messageframe_pdu{ &asn_DEF_MessageFrame }
+    , payload_node_{}
+    , hex_data_{}
+    , plans{}
+    , plan_key{}
+    , plan{ nullptr }
+    , output_size_hint{ 4096 }
+    , constraint_samples{}
+    , bsm_batch{}
+    , bsm_batch_output{}
+{
+}
+
+CodecContext::~CodecContext() {
+    asn_arena_destroy( arena );
+}
+
+CodecPlan::CodecPlan() :
+    opsflag{0}
+    , decode_1609dot2{ false }
+    , decode_messageframe{ false }
+    , decode_asdframe{ false }
+    , decode_1609dot2_type{ATS_CANONICAL_OER}
+    , decode_messageframe_type{ATS_UNALIGNED_BASIC_PER}
+    , decode_asdframe_type{ATS_UNALIGNED_BASIC_PER}
+    , messageframe_pdu{ &asn_DEF_MessageFrame }
+    , encodable{ false }
+    , encode_steps{}
+{
+}
+
 ASN1_Codec::ASN1_Codec( const std::string& name, const std::string& description ) :
     Tool{ name, description }
     , exit_eof{true}
@@ -171,6 +199,12 @@ ASN1_Codec::ASN1_Codec( const std::string& name, const std::string& description
     , msg_recv_bytes{0}
     , msg_send_bytes{0}
     , msg_filt_bytes{0}
+    , msg_fail_count{0}
+    , constraint_checks{0}
+    , constraint_violations{0}
+    , default_constraint_policy{}
+    , constraint_policies{}
+    , projections{}
     , pconf{}
     , brokers{"localhost"}
     , partition{RdKafka::Topic::PARTITION_UA}
@@ -178,36 +212,68 @@ ASN1_Codec::ASN1_Codec( const std::string& name, const std::string& description
     , debug{""}
     , consumed_topics{}
     , offset{RdKafka::Topic::OFFSET_BEGINNING}
-    , published_topic_name{}
+    , pipelines{}
+    , pipeline_topics{}
     , conf{nullptr}
     , tconf{nullptr}
     , consumer_ptr{}
     , consumer_timeout{500}
     , producer_ptr{}
-    , published_topic_ptr{}
-    , input_doc{}
-    , internal_doc{}
+    , codec_threads{1}
+    , codec_queue_size{64}
+    , arena_block_size{65536}
+    , codec_inputs{}
+    , codec_outputs{}
+    , consumed_offsets{}
+    , codec_workers{}
+    , egress{}
+    , next_worker{0}
+    , ingest_done{ false }
+    , workers_done{ 0 }
+    , msg_steal_count{ 0 }
+    , output_ordered{ true }
+    , output_format{ OutputFormat::XML }
+    , bsm_batches{ false }
+    , bsm_batch_rows{ 4096 }
+    , bsm_batch_age{ 1000 }
+    , bsm_batch_directory{}
+    , bsm_batch_topic{}
+    , bsm_batch_topic_ptr{}
+    , bsm_batch_count{ 0 }
+    , bsm_batch_row_count{ 0 }
+    , partition_trackers{}
+    , partition_pauses{}
+    , partition_max_in_flight{0}
+    , rebalancer{ *this }
+    , subscribed{ false }
+    , rebalanced{ false }
+    , revoked_partitions{}
+    , msg_tracked_count{0}
+    , msg_completed_count{0}
+    , thread_cpus{}
+    , numa_node{ -1 }
+    , delivery_reporter{ *this }
+    , delivery_poller{}
+    , delivery_polling{ false }
+    , produce_backpressure{ false }
+    , held_outputs{}
+    , batch_size{1}
+    , batch_linger_us{0}
     , error_doc{}
     , xml_parse_options{ pugi::parse_default | pugi::parse_declaration | pugi::parse_doctype | pugi::parse_trim_pcdata }
-    , ieee1609dot2_unsecuredData_query{"Ieee1609Dot2Data/content//unsecuredData"}  // this will work on both signed and unsigned
     , ode_payload_query{"OdeAsn1Data/payload/data"}
-    , ode_encodings_query{"OdeAsn1Data/metadata/encodings"}
-    , erroross{}
-    , byte_buffer{}
-	, opsflag{0}
-    , decode_1609dot2{ false }
-    , decode_messageframe{ false }
-	, decode_asdframe{ false }
+    , asn1_types{ asn_pdu_collection }
+    , main_context{}
 	, decode_functionality{ true }
-	, decode_1609dot2_type{ATS_CANONICAL_OER}
-	, decode_messageframe_type{ATS_UNALIGNED_BASIC_PER}
-	, decode_asdframe_type{ATS_UNALIGNED_BASIC_PER}
     , logger{}
 {
 }
 
 ASN1_Codec::~ASN1_Codec() 
 {
+    stop_codec_workers();
+    stop_delivery_poller();
+
     if (consumer_ptr) {
         consumer_ptr->close();
     }
@@ -462,6 +528,17 @@ bool ASN1_Codec::configure() {
         return false;
     } 
 
+    search = pconf.find("acm.arena.block.size");
+    if ( search != pconf.end() ) {
+        try {
+            arena_block_size = static_cast<std::size_t>( std::max( 0LL, std::stoll( search->second ) ) );
+        } catch( std::exception& e ) {
+            logger->info(fnname + ": using the default decode arena block size.");
+        }
+    }
+
+    init_codec_context( main_context );
+
     if ( optIsSet('b') ) {
         // broker specified.
         logger->info(fnname + ": setting kafka broker to: " + optString('b'));
@@ -506,6 +583,16 @@ bool ASN1_Codec::configure() {
         return false;
     }
 
+    // static membership: a replica that restarts with the same id gets its partitions back without a rebalance.
+    const char* instance_id = std::getenv("ACM_GROUP_INSTANCE_ID");
+    if ( instance_id && *instance_id ) {
+        if ( conf->set("group.instance.id", instance_id, error_string) != RdKafka::Conf::CONF_OK ) {
+            logger->error(fnname + ": kafka error setting configuration parameter group.instance.id: " + error_string);
+            return false;
+        }
+        logger->info(fnname + ": static group member: " + std::string(instance_id));
+    }
+
     if ( getOption('o').isSet() ) {
         // offset in the consumed stream.
         std::string o = optString( 'o' );
@@ -534,33 +621,19 @@ bool ASN1_Codec::configure() {
     // librdkafka defined configuration.
     conf->set("default_topic_conf", tconf, error_string);
 
-    search = pconf.find("asn1.topic.consumer");
-    if ( search != pconf.end() ) {
-        consumed_topics.push_back( search->second );
-        logger->info(fnname + ": consumed topic: " + search->second);
-
-    } else {
-        
-        logger->error(fnname + ": no consumer topic was specified; must fail.");
+    // delivery reports are served by a dedicated poll thread; see start_delivery_poller().
+    if ( conf->set("dr_cb", &delivery_reporter, error_string) != RdKafka::Conf::CONF_OK ) {
+        logger->error(fnname + ": kafka error setting the delivery report callback: " + error_string);
         return false;
     }
 
-    if (optIsSet('t')) {
-        // this is the produced (filtered) topic.
-        published_topic_name = optString( 't' );
-
-    } else {
-        // maybe it was specified in the configuration file.
-        auto search = pconf.find("asn1.topic.producer");
-        if ( search != pconf.end() ) {
-            published_topic_name = search->second;
-        } else {
-            logger->error(fnname + ": no publisher topic was specified; must fail.");
-            return false;
-        }
+    // revoked partitions are drained and committed before they are given up; see Rebalancer.
+    if ( conf->set("rebalance_cb", &rebalancer, error_string) != RdKafka::Conf::CONF_OK ) {
+        logger->error(fnname + ": kafka error setting the rebalance callback: " + error_string);
+        return false;
     }
 
-    logger->info(fnname + ": published topic: " + published_topic_name);
+    if ( !configure_pipelines() ) return false;
 
     search = pconf.find("asn1.consumer.timeout.ms");
     if ( search != pconf.end() ) {
@@ -571,10 +644,257 @@ bool ASN1_Codec::configure() {
         }
     }
 
+    search = pconf.find("acm.threads");
+    if ( search != pconf.end() ) {
+        try {
+            codec_threads = std::max( 1, std::stoi( search->second ) );
+        } catch( std::exception& e ) {
+            logger->info(fnname + ": using the default number of codec threads.");
+        }
+    }
+
+    search = pconf.find("acm.queue.size");
+    if ( search != pconf.end() ) {
+        try {
+            codec_queue_size = std::max( 1, std::stoi( search->second ) );
+        } catch( std::exception& e ) {
+            logger->info(fnname + ": using the default codec queue size.");
+        }
+    }
+
+    logger->info(fnname + ": codec threads: " + std::to_string(codec_threads) + " queue size: " + std::to_string(codec_queue_size));
+
+    // by default a partition may hold half of the pipeline before it is paused; one worker never holds more than a batch.
+    partition_max_in_flight = codec_threads > 1 ? codec_threads * codec_queue_size / 2 : 0;
+
+    search = pconf.find("acm.partition.inflight.max");
+    if ( search != pconf.end() ) {
+        try {
+            partition_max_in_flight = std::max( 0, std::stoi( search->second ) );
+        } catch( std::exception& e ) {
+            logger->info(fnname + ": using the default partition in-flight limit.");
+        }
+    }
+
+    logger->info(fnname + ": partition in-flight limit: " + std::to_string(partition_max_in_flight));
+
+    search = pconf.find("acm.batch.size");
+    if ( search != pconf.end() ) {
+        try {
+            batch_size = std::max( 1, std::stoi( search->second ) );
+        } catch( std::exception& e ) {
+            logger->info(fnname + ": using the default batch size.");
+        }
+    }
+
+    search = pconf.find("acm.batch.linger.us");
+    if ( search != pconf.end() ) {
+        try {
+            batch_linger_us = std::max( 0LL, std::stoll( search->second ) );
+        } catch( std::exception& e ) {
+            logger->info(fnname + ": using the default batch linger time.");
+        }
+    }
+
+    logger->info(fnname + ": batch size: " + std::to_string(batch_size) + " linger: " + std::to_string(batch_linger_us) + " us");
+
+    search = pconf.find("acm.output.order");
+    if ( search != pconf.end() ) {
+        if ( "completion" == search->second ) output_ordered = false;
+        else if ( "input" == search->second ) output_ordered = true;
+    }
+
+    logger->info(fnname + ": output order: " + std::string( output_ordered ? "input" : "completion" ));
+
+    search = pconf.find("acm.output.format");
+    if ( search != pconf.end() ) {
+        if ( "json" == search->second ) output_format = OutputFormat::JSON;
+        else if ( "cbor" == search->second ) output_format = OutputFormat::CBOR;
+        else if ( "xml" == search->second ) output_format = OutputFormat::XML;
+        else {
+            logger->error(fnname + ": unknown acm.output.format: " + search->second);
+            return false;
+        }
+    }
+
+    static const char* const format_names[] = { "xml", "json", "cbor" };
+    logger->info(fnname + ": output format: " + std::string( format_names[ static_cast<uint32_t>( output_format ) ] ));
+
+    if ( !configure_constraints() ) return false;
+    if ( !configure_projections() ) return false;
+    if ( !configure_uper_skips() ) return false;
+    if ( !configure_bsm_batches() ) return false;
+    if ( !configure_affinity() ) return false;
+
+    // offsets are stored by the partition trackers once every earlier message has been published; the automatic
+    // commit then only ever commits a contiguous prefix.
+    if ( conf->set("enable.auto.offset.store", "false", error_string) != RdKafka::Conf::CONF_OK ) {
+        logger->error(fnname + ": kafka error setting configuration parameter enable.auto.offset.store: " + error_string);
+        return false;
+    }
+
     logger->trace(fnname + ": finished.");
     return true;
 }
 
+/**
+ * Build the pipelines. With acm.pipelines (a comma separated list of names) each pipeline is described by
+ * acm.pipeline.<name>.type, acm.pipeline.<name>.topic.consumer, and acm.pipeline.<name>.topic.producer; otherwise the
+ * single pipeline of acm.type (or -T), asn1.topic.consumer, and asn1.topic.producer (or -t) is used.
+ */
+bool ASN1_Codec::configure_pipelines() {
+    const std::string fnname = "configure_pipelines()";
+
+    auto search = pconf.find("acm.pipelines");
+    if ( search == pconf.end() ) {
+        Pipeline p{ "default", "", "", decode_functionality, nullptr, false, "" };
+
+        search = pconf.find("asn1.topic.consumer");
+        if ( search == pconf.end() ) {
+            logger->error(fnname + ": no consumer topic was specified; must fail.");
+            return false;
+        }
+        p.consumer_topic = search->second;
+
+        if (optIsSet('t')) {
+            // this is the produced (filtered) topic.
+            p.producer_topic = optString( 't' );
+
+        } else {
+            // maybe it was specified in the configuration file.
+            search = pconf.find("asn1.topic.producer");
+            if ( search == pconf.end() ) {
+                logger->error(fnname + ": no publisher topic was specified; must fail.");
+                return false;
+            }
+            p.producer_topic = search->second;
+        }
+
+        if ( !configure_raw_input( p, "acm." ) ) return false;
+        pipelines.push_back( p );
+
+    } else {
+
+        for ( std::string name : string_utilities::split( search->second, ',' ) ) {
+            string_utilities::strip( name );
+            if ( name.empty() ) continue;
+
+            const std::string prefix = "acm.pipeline." + name + ".";
+            Pipeline p{ name, "", "", decode_functionality, nullptr, false, "" };
+
+            auto type = pconf.find( prefix + "type" );
+            if ( type != pconf.end() ) {
+                if ( "encode" == type->second ) p.decode = false;
+                else if ( "decode" == type->second ) p.decode = true;
+                else {
+                    logger->error(fnname + ": pipeline " + name + " has an unknown type: " + type->second);
+                    return false;
+                }
+            }
+
+            auto consumer = pconf.find( prefix + "topic.consumer" );
+            auto producer = pconf.find( prefix + "topic.producer" );
+            if ( consumer == pconf.end() || producer == pconf.end() ) {
+                logger->error(fnname + ": pipeline " + name + " needs both " + prefix + "topic.consumer and " + prefix + "topic.producer; must fail.");
+                return false;
+            }
+
+            p.consumer_topic = consumer->second;
+            p.producer_topic = producer->second;
+
+            if ( !configure_raw_input( p, prefix ) ) return false;
+            pipelines.push_back( p );
+        }
+
+        if ( pipelines.empty() ) {
+            logger->error(fnname + ": acm.pipelines does not name any pipeline; must fail.");
+            return false;
+        }
+    }
+
+    for ( std::size_t i = 0; i < pipelines.size(); ++i ) {
+        const Pipeline& p = pipelines[i];
+
+        // a consumed message must map to exactly one direction and output topic.
+        if ( !pipeline_topics.emplace( p.consumer_topic, i ).second ) {
+            logger->error(fnname + ": topic " + p.consumer_topic + " is consumed by more than one pipeline; must fail.");
+            return false;
+        }
+
+        consumed_topics.push_back( p.consumer_topic );
+        logger->info(fnname + ": pipeline " + p.name + " " + ( p.decode ? "decodes" : "encodes" ) + " consumed topic: " + p.consumer_topic + " to published topic: " + p.producer_topic);
+    }
+
+    return true;
+}
+
+/**
+ * Parse a list of elementType:encodingRule pairs, outermost first (e.g., Ieee1609Dot2Data:COER,MessageFrame:UPER), into
+ * the key of its codec plan; the same key set_codec_requirements builds from an encodings block.
+ *
+ * @return false if an entry does not have both parts.
+ */
+static bool encodings_plan_key( const std::string& list, std::string& key ) {
+    key.clear();
+    if ( list.find( '\0' ) != std::string::npos ) return false;
+
+    for ( std::string entry : string_utilities::split( list, ',' ) ) {
+        string_utilities::strip( entry );
+        if ( entry.empty() ) continue;
+
+        StrPair pair = string_utilities::split_attribute( entry, ':' );
+        string_utilities::strip( pair.first );
+        string_utilities::strip( pair.second );
+        if ( pair.first.empty() || pair.second.empty() ) return false;
+
+        key.append( pair.first );
+        key.push_back( '\0' );
+        key.append( pair.second );
+        key.push_back( '\0' );
+    }
+
+    return !key.empty();
+}
+
+/**
+ * Read the input format of a pipeline: <prefix>input is xml (the default) or raw, and <prefix>input.encodings gives
+ * the encodings of raw records that do not carry an encodings header.
+ */
+bool ASN1_Codec::configure_raw_input( Pipeline& p, const std::string& prefix ) {
+    const std::string fnname = "configure_raw_input()";
+
+    auto search = pconf.find( prefix + "input" );
+    if ( search == pconf.end() || "xml" == search->second ) return true;
+
+    if ( "raw" != search->second ) {
+        logger->error(fnname + ": pipeline " + p.name + " has an unknown input format: " + search->second);
+        return false;
+    }
+
+    if ( !p.decode ) {
+        logger->error(fnname + ": pipeline " + p.name + " encodes; only decoding pipelines can take raw input.");
+        return false;
+    }
+
+    p.raw_input = true;
+
+    search = pconf.find( prefix + "input.encodings" );
+    if ( search != pconf.end() && !encodings_plan_key( search->second, p.raw_plan_key ) ) {
+        logger->error(fnname + ": pipeline " + p.name + " has malformed input encodings: " + search->second);
+        return false;
+    }
+
+    logger->info(fnname + ": pipeline " + p.name + " consumes raw ASN.1 records" + ( search == pconf.end() ? "" : " encoded as " + search->second ));
+    return true;
+}
+
+const ASN1_Codec::Pipeline& ASN1_Codec::pipeline_for( const RdKafka::Message* msg ) const {
+    if ( pipelines.size() == 1 ) return pipelines.front();
+
+    auto it = pipeline_topics.find( msg->topic_name() );
+    return it == pipeline_topics.end() ? pipelines.front() : pipelines[ it->second ];
+}
+
 bool ASN1_Codec::launch_producer() {
     std::string error_string;
 
@@ -584,16 +904,58 @@ bool ASN1_Codec::launch_producer() {
         return false;
     }
 
-    published_topic_ptr = std::shared_ptr<RdKafka::Topic>( RdKafka::Topic::create(producer_ptr.get(), published_topic_name, tconf, error_string) );
-    if ( !published_topic_ptr ) {
-        logger->critical("Failed to create topic: " + published_topic_name + ". Error: " + error_string + ".");
-        return false;
-    } 
+    // one producer serves every pipeline.
+    for ( auto& p : pipelines ) {
+        p.producer_topic_ptr = std::shared_ptr<RdKafka::Topic>( RdKafka::Topic::create(producer_ptr.get(), p.producer_topic, tconf, error_string) );
+        if ( !p.producer_topic_ptr ) {
+            logger->critical("Failed to create topic: " + p.producer_topic + ". Error: " + error_string + ".");
+            return false;
+        } 
+
+        logger->info("Producer: " + producer_ptr->name() + " created using topic: " + p.producer_topic + ".");
+    }
+
+    if ( !bsm_batch_topic.empty() ) {
+        bsm_batch_topic_ptr = std::shared_ptr<RdKafka::Topic>( RdKafka::Topic::create(producer_ptr.get(), bsm_batch_topic, tconf, error_string) );
+        if ( !bsm_batch_topic_ptr ) {
+            logger->critical("Failed to create topic: " + bsm_batch_topic + ". Error: " + error_string + ".");
+            return false;
+        }
+    }
 
-    logger->info("Producer: " + producer_ptr->name() + " created using topic: " + published_topic_name + ".");
     return true;
 }
 
+/**
+ * @return the consumed topics that are not in the cluster's metadata; all of them if the metadata cannot be read.
+ */
+std::vector<std::string> ASN1_Codec::missing_topics() {
+    std::vector<std::string> missing;
+    std::set<std::string> known;
+
+    RdKafka::Metadata* md = nullptr; // must be freed if allocated
+    RdKafka::ErrorCode err = consumer_ptr->metadata( true, nullptr, &md, 5000 );
+
+    if ( err == RdKafka::ERR_NO_ERROR ) {
+        for ( auto topic : *md->topics() ) {
+            known.insert( topic->topic() );
+        }
+    } else {
+        logger->error("cannot retrieve consumer metadata with error: " + err2str(err));
+    }
+
+    delete md;
+
+    for ( auto& topic : consumed_topics ) {
+        if ( known.count( topic ) == 0 ) {
+            missing.push_back( topic );
+            logger->warn("Metadata did not contain topic: " + topic);
+        }
+    }
+
+    return missing;
+}
+
 bool ASN1_Codec::launch_consumer(){
     std::string error_string;
 
@@ -607,35 +969,36 @@ bool ASN1_Codec::launch_consumer(){
         }
     }
 
-    // wait on the topics we specified to become available for subscription.
+    // the subscription survives a relaunch (e.g., after exit_eof); the group keeps the assignment, so do not wait again.
+    if ( subscribed ) {
+        logger->info("Consumer: " + consumer_ptr->name() + " is already subscribed.");
+        return true;
+    }
+
+    // wait on the topics we specified to become available for subscription; one metadata request covers all of them.
     // loop terminates with a signal (CTRL-C) or when all the topics are available.
-    int tcount = 0;
-    for ( auto& topic : consumed_topics ) {
-        while ( data_available && tcount < consumed_topics.size() ) {
-            if ( topic_available(topic) ) {
-                logger->trace("Consumer topic: " + topic + " is available.");
-                // count it and attempt to get the next one if it exists.
-                ++tcount;
-                break;
-            }
-            // topic is not available, wait for a second or two.
-            std::this_thread::sleep_for( std::chrono::milliseconds( 1500 ) );
-            logger->trace("Waiting for needed consumer topic: " + topic + ".");
-        }
+    std::vector<std::string> missing = missing_topics();
+    while ( data_available && !missing.empty() ) {
+        // a topic is not available, wait for a second or two.
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1500 ) );
+        logger->trace("Waiting for " + std::to_string(missing.size()) + " needed consumer topics, e.g., " + missing.front() + ".");
+        missing = missing_topics();
     }
 
-    if ( tcount == consumed_topics.size() ) {
-        // all the needed topics are available for subscription.
-        RdKafka::ErrorCode status = consumer_ptr->subscribe(consumed_topics);
-        if (status) {
-            logger->critical("Failed to subscribe to " + std::to_string(consumed_topics.size()) + " topics. Error: " + RdKafka::err2str(status) + ".");
-            return false;
-        }
-    } else {
+    if ( !missing.empty() ) {
         logger->warn("User cancelled ASN1_Codec while waiting for topics to become available.");
         return false;
     }
 
+    // all the needed topics are available for subscription.
+    RdKafka::ErrorCode status = consumer_ptr->subscribe(consumed_topics);
+    if (status) {
+        logger->critical("Failed to subscribe to " + std::to_string(consumed_topics.size()) + " topics. Error: " + RdKafka::err2str(status) + ".");
+        return false;
+    }
+
+    subscribed = true;
+
     std::ostringstream osbuf{};
     for ( auto& topic : consumed_topics ) {
         if ( osbuf.tellp() != 0 ) osbuf << ", ";
@@ -807,65 +1170,12 @@ bool ASN1_Codec::add_error_xml( pugi::xml_document& doc, Asn1DataType dt, Asn1Er
 }
 
 bool ASN1_Codec::hex_to_bytes_(const std::string& payload_hex, std::vector<char>& buf) {
-    uint8_t d = 0;
-    int i = 0;          // so we can return -1;
-
-    for (const char& c : payload_hex) {
-        if ( c <= '9' && c >= '0' ) {
-            d = c-'0';
-        } else if ( c <= 'F' && c >= 'A' ) {
-            d = c-55;       // c - 'A' + 10
-        } else if ( c <= 'f' && c >= 'a' ) {
-            d = c-87;        // c - 'a' + 10;
-        } else {
-            return false;
-        }
-
-        if (i%2) {
-            // low order nibble.
-            buf.back() |= d;
-        } else {
-            // high order nibble.
-            buf.push_back( d<<4 );
-        }
-        ++i;
-    }
-
-    // the number of bytes in the buf.
-    return true;
+    // whitespace is skipped while converting; the bytes are appended to buf.
+    return hex_codec::decode( payload_hex.data(), payload_hex.size(), buf );
 }
 
-bool ASN1_Codec::bytes_to_hex_(buffer_structure_t* buf_struct, std::string& hex_vector ) {
-    char c = 0;
-
-    hex_vector.clear();
-    for ( std::size_t i = 0; i < buf_struct->buffer_size; ++i ) {
-
-        uint8_t bh = (buf_struct->buffer[i] & 0xF0) >> 4;
-
-        if ( bh <= 9 && bh >= 0 ) {
-            c = (bh+48); // b + '0'
-        } else if ( bh <= 15 && bh >= 10 ) {
-            c = (bh+55); // b + 'A' - 10;
-        } else {
-            return false;
-        }
-
-        hex_vector.push_back(c);
-
-        uint8_t bl = (buf_struct->buffer[i] & 0x0F);
-
-        if ( bl <= 9 && bl >= 0 ) {
-            c = (bl+48);
-        } else if ( bl <= 15 && bl >= 10 ) {
-            c = (bl+55);
-        } else {
-            return false;
-        }
-
-        hex_vector.push_back(c);
-    }
-
+bool ASN1_Codec::bytes_to_hex_(const char* bytes, std::size_t size, std::string& hex_vector ) {
+    hex_codec::encode( bytes, size, hex_vector );
     return true;
 }
 
@@ -910,10 +1220,10 @@ enum asn_transfer_syntax ASN1_Codec::get_ats_transfer_syntax( const char* ats )
     return r;
 }
 
-bool ASN1_Codec::process_message(RdKafka::Message* message, std::stringstream& output_message_stream ) {
+bool ASN1_Codec::process_message( CodecContext& ctx, RdKafka::Message* message, pugi::xml_writer& output ) {
     const std::string fnname = "process_message()";
-    static std::string tsname;
-    static RdKafka::MessageTimestamp ts;
+    std::string tsname;
+    RdKafka::MessageTimestamp ts;
     
     // flags for type of decoding required.
     pugi::xml_parse_result parse_result;
@@ -959,28 +1269,36 @@ bool ASN1_Codec::process_message(RdKafka::Message* message, std::stringstream& o
 
             // already verified non-zero message length.
 
-            parse_result = input_doc.load_buffer((const void*) message->payload(), message->len(), xml_parse_options );
+            if ( pipeline_for( message ).raw_input ) {
+                // the record is the ASN.1 encoding itself; there is no envelope to parse.
+                decode_raw_message( ctx, message, pipeline_for( message ), output );          // throws
+                return true;
+            }
+
+            parse_result = ctx.input_doc.load_buffer((const void*) message->payload(), message->len(), xml_parse_options );
 
             if (!parse_result) {
-                erroross.str("");
-                erroross << "Input file parse error: " << parse_result.description() << " at offset " << parse_result.offset;
-                throw UnparseableInputError{ erroross.str() };
+                ctx.erroross.str("");
+                ctx.erroross << "Input file parse error: " << parse_result.description() << " at offset " << parse_result.offset;
+                throw UnparseableInputError{ ctx.erroross.str() };
             } 
 
             // examine the input xml encodings information and set the flags and requirements needed to properly parse
             // the byte strings.
-            set_codec_requirements( input_doc );        // throws UnparseableInputErrors
+            set_codec_requirements( ctx );        // throws UnparseableInputErrors
 
-            payload_node_ = ode_payload_query.evaluate_node( input_doc ).node();
+            ctx.payload_node_ = ode_payload_query.evaluate_node( ctx.input_doc ).node();
 
-            if ( !payload_node_ ) {
+            if ( !ctx.payload_node_ ) {
                 throw UnparseableInputError{ "Failed to find the OdeAsn1Data/payload/data field in the input file." };
             }
 
-            if ( decode_functionality ) {
-                decode_message( payload_node_, output_message_stream );          // throws
+            prepare_output( ctx, message->payload(), message->len() );
+
+            if ( pipeline_for( message ).decode ) {
+                decode_message( ctx, ctx.payload_node_, output );          // throws
             } else {
-                encode_message( output_message_stream );          // throws
+                encode_message( ctx, output );          // throws
             }
                 
             return true;
@@ -1015,16 +1333,13 @@ bool ASN1_Codec::process_message(RdKafka::Message* message, std::stringstream& o
     return false;
 }
 
-bool ASN1_Codec::decode_message( pugi::xml_node& payload_node, std::stringstream& output_message_stream ) {
+bool ASN1_Codec::decode_message( CodecContext& ctx, pugi::xml_node& payload_node, pugi::xml_writer& output ) {
     const std::string fnname = "decode_message()";
     bool success = true;
-    pugi::xml_parse_result parse_result;
-
-    buffer_structure_t xb = {0, 0, 0};
 
     logger->trace(fnname + ": starting...");
 
-    if ( !decode_1609dot2 && !decode_messageframe ) {
+    if ( !ctx.decode_1609dot2 && !ctx.decode_messageframe ) {
         // if neither of these is set, this function becomes a noop and nothing will be returned, so this is an
         // exception.
         throw MissingInputElementError{"An decoder was not specified in the encodingType tag that this module understands."};
@@ -1039,83 +1354,128 @@ bool ASN1_Codec::decode_message( pugi::xml_node& payload_node, std::stringstream
         payload_node.remove_child("bytes");
 
         // Ieee 1609.2 is the outer frame.
-		if ( decode_1609dot2 ) {
-
-			decode_1609dot2_data(hstr, &xb);            // throws.
-
-			// asssert success == true;
-
-			// pugi resets the document as part of load_buffer
-			parse_result = internal_doc.load_buffer(static_cast<const void *>( xb.buffer), xb.buffer_size );
-
-			if ( !parse_result ) {
-				erroross.str("");
-				erroross << "IEEE 1609.2 decoded XER cannot be parsed/loaded as a valid document: " << parse_result.description() << " at offset " << parse_result.offset;
-				throw Asn1CodecError{ erroross.str() };
-			}
+		if ( ctx.decode_1609dot2 ) {
 
-			// XPath search the IEEE structure for the unsecured data.
-			pugi::xpath_node unsecuredDataNode = ieee1609dot2_unsecuredData_query.evaluate_node( internal_doc );
-			text = unsecuredDataNode.node().text();
-
-			if ( !text ) throw Asn1CodecError{"IEEE 1609.2 internal XER unsecuredData element could not be found."};
-
-			// replacing the original hex string, so the next processing step works.
-			hstr = std::string( text.get() );
-			internal_doc.reset();
-			std::free( static_cast<void *>(xb.buffer) );
-			xb = { 0,0,0 };                     // reset buffer;
+			// leaves the unsecured data bytes in ctx.byte_buffer for the next processing step.
+			decode_1609dot2_data( ctx, hstr );            // throws.
 		}
 
-		if ( success && decode_messageframe ) {
-
-			decode_messageframe_data( hstr, &xb );          // throws.
-
-			// asssert success == true;
+		if ( success && ctx.decode_messageframe ) {
 
 			// eliminate the original hex string, so the new XML can be inserted.
 			payload_node.text().set("");
-			parse_result = internal_doc.load_buffer( static_cast<const void *>( xb.buffer), xb.buffer_size );
 
-			if ( !parse_result ) {
-				erroross.str("");
-				erroross <<"J2735 decoded XER cannot be parsed/loaded as a valid document: "<< parse_result.description() << " at offset " << parse_result.offset;
-				throw Asn1CodecError{ erroross.str() };
+			if ( ctx.decode_1609dot2 ) {
+				decode_messageframe_bytes( ctx, payload_node );          // throws.
+			} else {
+				decode_messageframe_data( ctx, hstr, payload_node );          // throws.
 			}
 
-			payload_node.append_copy( internal_doc.document_element() );
-
 			if ( !payload_node.parent().child("dataType").text().set( asn1datatypes[static_cast<int>(Asn1DataType::XML)] ) ) {
 				throw MissingInputElementError{"Could not update the dataType field of the payload section."};
 			}
-
-			std::free( static_cast<void *>(xb.buffer) );
 		}
 
     } else {
         throw MissingInputElementError{"failure accessing input XML bytes node."};
     }
 
-    // convert DOM to a RAW string representation: no spaces, no tabs.
-    input_doc.save(output_message_stream,"",pugi::format_raw);
+    write_output( ctx, output );
     logger->trace(fnname + ": finished...");
     return success;
 } 
 
-void ASN1_Codec::encode_node_as_hex_string(bool replace) {
-    std::stringstream xml_stream;
-    std::string hex_str;
+/**
+ * Decode a raw record: its value is the ASN.1 encoding and its encodings come from a Kafka header or the pipeline. The
+ * output is the same OdeAsn1Data document a decoded XML input produces, built on the error template's envelope with
+ * the encodings filled in, so consumers of the output topic cannot tell the two inputs apart.
+ */
+bool ASN1_Codec::decode_raw_message( CodecContext& ctx, RdKafka::Message* message, const Pipeline& pipeline, pugi::xml_writer& output ) {
+    const std::string fnname = "decode_raw_message()";
+
+    set_raw_codec_requirements( ctx, message, pipeline );        // throws UnparseableInputErrors
+
+    if ( !ctx.decode_1609dot2 && !ctx.decode_messageframe ) {
+        throw MissingInputElementError{"An decoder was not specified in the encodings that this module understands."};
+    }
+
+    // the envelope; a failure below is reported in it like a failure of an XML input. There is no input text to splice.
+    ctx.output_splice.reset( nullptr, 0 );
+    ctx.input_doc.reset( error_doc );
+    pugi::xml_node metadata = ctx.input_doc.child("OdeAsn1Data").child("metadata");
+    pugi::xml_node payload = ctx.input_doc.child("OdeAsn1Data").child("payload");
+    if ( !metadata || !payload ) {
+        throw UnparseableInputError{"The error template has no OdeAsn1Data/metadata and OdeAsn1Data/payload to build the output on."};
+    }
+
+    std::string now = get_current_time();
+    metadata.child("receivedAt").text().set( now.c_str() );
+    metadata.child("generatedAt").text().set( now.c_str() );
+
+    pugi::xml_node encodings = metadata.child("encodings");
+    for ( const char* p = ctx.plan_key.c_str(); p < ctx.plan_key.c_str() + ctx.plan_key.size(); ) {
+        pugi::xml_node entry = encodings.append_child("encodings");
+        entry.append_child("elementType").text().set( p );
+        p += std::strlen( p ) + 1;
+        entry.append_child("encodingRule").text().set( p );
+        p += std::strlen( p ) + 1;
+    }
+
+    payload.remove_child("data");
+    ctx.payload_node_ = payload.append_child("data");
+
+    const char* bytes = static_cast<const char*>( message->payload() );
+    ctx.byte_buffer.assign( bytes, bytes + message->len() );
+
+    if ( ctx.decode_1609dot2 ) {
+        decode_1609dot2_bytes( ctx );           // throws.
+    }
+
+    if ( ctx.decode_messageframe ) {
+        decode_messageframe_bytes( ctx, ctx.payload_node_ );          // throws.
+        payload.child("dataType").text().set( asn1datatypes[static_cast<int>(Asn1DataType::XML)] );
+    } else {
+        // only the security envelope was asked for; pass on what it carries.
+        std::string hex;
+        bytes_to_hex_( ctx.byte_buffer.data(), ctx.byte_buffer.size(), hex );
+        ctx.payload_node_.append_child("bytes").text().set( hex.c_str() );
+        payload.child("dataType").text().set( asn1datatypes[static_cast<int>(Asn1DataType::HEX)] );
+    }
+
+    write_output( ctx, output );
+    logger->trace(fnname + ": finished...");
+    return true;
+}
+
+/**
+ * The first element at the end of the path of names below node; like xml_node::first_element_by_path, but the path
+ * is already split.
+ */
+static pugi::xml_node find_by_path( pugi::xml_node node, const std::vector<std::string>& names, std::size_t i = 0 ) {
+    if ( i == names.size() ) return node;
 
-    pugi::xml_node node = payload_node_.first_element_by_path(curr_node_path_.c_str());
+    for ( pugi::xml_node child = node.child( names[i].c_str() ); child; child = child.next_sibling( names[i].c_str() ) ) {
+        pugi::xml_node found = find_by_path( child, names, i + 1 );
+        if ( found ) return found;
+    }
+
+    return pugi::xml_node{};
+}
+
+void ASN1_Codec::encode_node_as_hex_string( CodecContext& ctx, const CodecPlan::EncodeStep& step ) {
+    std::stringstream xml_stream;
+    std::string hex_str;
+
+    pugi::xml_node node = find_by_path( ctx.payload_node_, step.path_names );
 
     if (!node) {
-        throw MissingInputElementError{"Failed to find path: " + curr_node_path_ + "in the input document."};
+        throw MissingInputElementError{"Failed to find path: " + step.path + "in the input document."};
     }
 
     pugi::xml_node parent_node = node.parent();
 
     if (!parent_node) {
-        throw MissingInputElementError{"Failed to find parent node for: " + curr_node_path_ + "in the input document."};
+        throw MissingInputElementError{"Failed to find parent node for: " + step.path + "in the input document."};
     }
 
     // convert the child to string stream 
@@ -1127,12 +1487,12 @@ void ASN1_Codec::encode_node_as_hex_string(bool replace) {
     }
 
     // do the encoding
-    encode_frame_data(xml_stream.str(), hex_str);
+    encode_frame_data( ctx, step.type, step.syntax, xml_stream.str(), hex_str );
 
     std::string node_name(node.name());
-    hex_data_.push_back(std::make_tuple(node_name, hex_str));
+    ctx.hex_data_.push_back(std::make_tuple(node_name, hex_str));
 
-    if (!replace) {
+    if (!step.replace) {
         return;
     }
 
@@ -1142,101 +1502,248 @@ void ASN1_Codec::encode_node_as_hex_string(bool replace) {
     }
 }
 
-void ASN1_Codec::encode_for_protocol() {
-    for (auto& part : protocol_) {
-        curr_op_ = std::get<0>(part);
-        curr_decode_type_ = std::get<1>(part);
-        curr_node_path_ = std::get<2>(part);
-
-        encode_node_as_hex_string(std::get<3>(part));
+void ASN1_Codec::encode_for_protocol( CodecContext& ctx ) {
+    for (const CodecPlan::EncodeStep& step : ctx.plan->encode_steps) {
+        encode_node_as_hex_string( ctx, step );
     }
 
-    for (auto& data : hex_data_) {
+    for (auto& data : ctx.hex_data_) {
         std::string node_name = std::get<0>(data);
         std::string hex_str = std::get<1>(data);
 
-        if ( !payload_node_.append_child(node_name.c_str()).append_child("bytes").text().set(hex_str.c_str()) ) {
+        if ( !ctx.payload_node_.append_child(node_name.c_str()).append_child("bytes").text().set(hex_str.c_str()) ) {
             throw MissingInputElementError{"Failure to append path: OdeAsn1Data/payload/data/" + node_name + "/bytes to the output document."};
         }
     }
 
-    if (!payload_node_.parent().child("dataType").text().set( asn1datatypes[static_cast<int>(Asn1DataType::HEX)] ) ) {
+    if (!ctx.payload_node_.parent().child("dataType").text().set( asn1datatypes[static_cast<int>(Asn1DataType::HEX)] ) ) {
             throw MissingInputElementError{"Failure to update path: OdeAsn1Data/payload/dataType in the output document."};
     }
 }
 
 // throws MissingInputElementError or Asn1CodecError (from encode_messageframe_data call) ONLY!
-bool ASN1_Codec::encode_message( std::stringstream& output_message_stream ) {
+bool ASN1_Codec::encode_message( CodecContext& ctx, pugi::xml_writer& output ) {
 
     const std::string fnname = "encode_message()";
 
-    protocol_.clear();
-    hex_data_.clear();
+    ctx.hex_data_.clear();
 
-    switch (opsflag) {
-        case IEEE1609DOT2:
-            protocol_.push_back(std::make_tuple(IEEE1609DOT2, decode_1609dot2_type, "Ieee1609Dot2Data", false));
+    if ( !ctx.plan->encodable ) {
+        throw MissingInputElementError{"An encoder was not specified in the encodingType tag that this module understands."};
+    }
+    
+    encode_for_protocol( ctx );
+    
+    write_output( ctx, output );
 
-            break;
-        case J2735MESSAGEFRAME:
-            protocol_.push_back(std::make_tuple(J2735MESSAGEFRAME, decode_messageframe_type, "MessageFrame", false));
+    return true;
+}
 
-            break;
-        case IEEE1609DOT2_J2735MESSAGEFRAME:
-            protocol_.push_back(std::make_tuple(J2735MESSAGEFRAME, decode_messageframe_type, "Ieee1609Dot2Data/content/unsecuredData/MessageFrame", true));
-            protocol_.push_back(std::make_tuple(IEEE1609DOT2, decode_1609dot2_type, "Ieee1609Dot2Data", false));
+/**
+ * Find the named component of a decoded SEQUENCE or CHOICE value using its type descriptor; a CHOICE only yields its
+ * present alternative. This does not depend on how asn1c laid out the C structures (inline or by pointer).
+ *
+ * @return the component's value, or nullptr if it is absent; on success td is the component's type.
+ */
+static const void* asn1_component( const asn_TYPE_descriptor_t*& td, const void* sptr, const char* name ) {
+    const asn_TYPE_member_t* elm = nullptr;
 
-            break;
-        case ASDFRAME:
-            protocol_.push_back(std::make_tuple(ASDFRAME, decode_asdframe_type, "AdvisorySituationData", false));
+    if ( !sptr ) return nullptr;
 
-            break;
-        case ASDFRAME_IEEE1609DOT2:
-            protocol_.push_back(std::make_tuple(IEEE1609DOT2, decode_1609dot2_type, "AdvisorySituationData/asdmDetails/advisoryMessage/Ieee1609Dot2Data", true));
-            protocol_.push_back(std::make_tuple(ASDFRAME, decode_asdframe_type, "AdvisorySituationData", false));
+    if ( td->op == &asn_OP_CHOICE ) {
+        unsigned present = CHOICE_variant_get_presence( td, sptr );
+        if ( present == 0 || present > td->elements_count ) return nullptr;
 
-            break;
-        case ASDFRAME_J2735MESSAGEFRAME:
-            protocol_.push_back(std::make_tuple(J2735MESSAGEFRAME, decode_messageframe_type, "AdvisorySituationData/asdmDetails/advisoryMessage/MessageFrame", true));
-            protocol_.push_back(std::make_tuple(ASDFRAME, decode_asdframe_type, "AdvisorySituationData", false));
+        elm = &td->elements[ present - 1 ];
+        if ( std::strcmp( elm->name, name ) != 0 ) return nullptr;
 
-            break;
-        case ASDFRAME_IEEE1609DOT2_J2735MESSAGEFRAME:
-            protocol_.push_back(std::make_tuple(J2735MESSAGEFRAME, decode_messageframe_type, "AdvisorySituationData/asdmDetails/advisoryMessage/Ieee1609Dot2Data/content/unsecuredData/MessageFrame", true));
-            protocol_.push_back(std::make_tuple(IEEE1609DOT2, decode_1609dot2_type, "AdvisorySituationData/asdmDetails/advisoryMessage/Ieee1609Dot2Data", true));
-            protocol_.push_back(std::make_tuple(ASDFRAME, decode_asdframe_type, "AdvisorySituationData", false));
+    } else {
+        for ( unsigned i = 0; i < td->elements_count && !elm; ++i ) {
+            if ( std::strcmp( td->elements[i].name, name ) == 0 ) elm = &td->elements[i];
+        }
+        if ( !elm ) return nullptr;
+    }
 
+    const void* mptr = static_cast<const char*>( sptr ) + elm->memb_offset;
+    if ( elm->flags & ATF_POINTER ) {
+        mptr = *static_cast<const void* const*>( mptr );
+    }
 
-            break;
-        default:
-            throw MissingInputElementError{"An encoder was not specified in the encodingType tag that this module understands."};
+    td = elm->type;
+    return mptr;
+}
+
+/**
+ * Find the unsecuredData of a decoded Ieee1609Dot2Data: its content, or for signed data the content of the
+ * Ieee1609Dot2Data carried in signedData/tbsData/payload/data (the places the Ieee1609Dot2Data/content//unsecuredData
+ * XPath used to search).
+ */
+static const OCTET_STRING_t* find_unsecured_data( const void* data ) {
+    // signed data nests another Ieee1609Dot2Data; the bound only guards against hostile input.
+    for ( int depth = 0; data && depth < 8; ++depth ) {
+        const asn_TYPE_descriptor_t* td = &asn_DEF_Ieee1609Dot2Data;
+        const void* content = asn1_component( td, data, "content" );
+
+        const asn_TYPE_descriptor_t* choice_td = td;
+        const void* unsecured = asn1_component( choice_td, content, "unsecuredData" );
+        if ( unsecured ) return static_cast<const OCTET_STRING_t*>( unsecured );
 
+        const void* v = asn1_component( td, content, "signedData" );
+        v = asn1_component( td, v, "tbsData" );
+        v = asn1_component( td, v, "payload" );
+        data = asn1_component( td, v, "data" );
     }
-    
-    encode_for_protocol();
-    
-    // convert DOM to a RAW string representation: no spaces, no tabs.
-    // for testing.
-    input_doc.save(output_message_stream, "", pugi::format_raw);
 
-    return true;
+    return nullptr;
 }
 
 /** 
  * Decodes the IEEE 1609.2 ASN.1 bytes represented by the hex string according to the instance type variable:
- * decode_1609dot2_type into its C structure, then encodes the C structure into XML. The XML is put into the xml_buffer.
+ * ctx.decode_1609dot2_type into its C structure, then copies the unsecuredData bytes it carries into ctx.byte_buffer so
+ * the next layer can be decoded without another hex conversion.
  *
- * This method does not NORMALLY modify the input_doc directly.
- * This method will modify the input_doc on error. 
+ * This method does not modify the ctx.input_doc.
  *
- * Return true on success: use the xml_buffer to generate valid XML to use to extract out the next layer.
- * Return false on failure: immediately use the input_doc to return what happened during decoding of 1609.2
+ * Return true on success: ctx.byte_buffer holds the unsecured data.
  */
 
 // throws Asn1CodecError ONLY!
-bool ASN1_Codec::decode_1609dot2_data( std::string& data_as_hex, buffer_structure_t* xml_buffer ) {
+bool ASN1_Codec::decode_1609dot2_data( CodecContext& ctx, std::string& data_as_hex ) {
     const std::string fnname = "decode_1609dot2_data()";
 
+    logger->trace(fnname + ": starting...");
+
+    logger->trace(fnname + ": success extracting " + asn_DEF_Ieee1609Dot2Data.name + " hex string: " + data_as_hex );
+
+    // whitespace is skipped by the conversion.
+    ctx.byte_buffer.clear();
+    if (!hex_to_bytes_(data_as_hex, ctx.byte_buffer)) {
+        throw Asn1CodecError{"failed attempt to decode IEEE 1609.2 hex string: cannot convert to bytes."};
+    }
+
+    if (ctx.byte_buffer.empty()) {
+        throw Asn1CodecError{"failed attempt to decode IEEE 1609.2 hex string: string empty."};
+    }
+
+    logger->trace(fnname + ": successful conversion to raw byte buffer." );
+
+    return decode_1609dot2_bytes( ctx );
+}
+
+/**
+ * Decode the IEEE 1609.2 frame in ctx.byte_buffer and replace it with the unsecuredData bytes it carries.
+ */
+
+// throws Asn1CodecError ONLY!
+bool ASN1_Codec::decode_1609dot2_bytes( CodecContext& ctx ) {
+    const std::string fnname = "decode_1609dot2_bytes()";
+
+    Ieee1609Dot2Data_t *ieee1609data = 0;        // must initialize to 0 according to asn.1 instructions.
+
+    // Decode BAH Bytes (A 1609.2 Frame) into the appropriate structure.
+    ieee1609data = static_cast<Ieee1609Dot2Data_t*>( decode_pdu( ctx, &asn_DEF_Ieee1609Dot2Data, ctx.decode_1609dot2_type ) );
+
+    // take the payload straight from the decoded structure; the decoded bytes were copied, so byte_buffer is free.
+    const OCTET_STRING_t* unsecured = find_unsecured_data( ieee1609data );
+    if ( !unsecured ) {
+        free_pdu( ctx, &asn_DEF_Ieee1609Dot2Data, ieee1609data );
+        throw Asn1CodecError{"IEEE 1609.2 unsecuredData element could not be found."};
+    }
+
+    ctx.byte_buffer.assign( unsecured->buf, unsecured->buf + unsecured->size );
+    free_pdu( ctx, &asn_DEF_Ieee1609Dot2Data, ieee1609data );
+
+    logger->trace(fnname + ": finished.");
+    return true;
+}
+
+/**
+ * Decode the hex string as the ctx.messageframe_pdu type and append its XML form to parent.
+ */
+bool ASN1_Codec::decode_messageframe_data( CodecContext& ctx, std::string& data_as_hex, pugi::xml_node& parent ) {
+    const std::string fnname = "decode_messageframe_data()";
+
+    logger->trace(fnname + ": starting...");
+
+    logger->trace(fnname + ": success extracting " + ctx.messageframe_pdu->name + " hex string: " + data_as_hex);
+
+    // whitespace is skipped by the conversion.
+    ctx.byte_buffer.clear();
+    if (!hex_to_bytes_(data_as_hex, ctx.byte_buffer)) {
+        throw Asn1CodecError{"failed attempt to decode " + std::string{ ctx.messageframe_pdu->name } + " hex string: cannot convert to bytes."};
+    }
+
+    if (ctx.byte_buffer.empty()) {
+        throw Asn1CodecError{"failed attempt to decode " + std::string{ ctx.messageframe_pdu->name } + " hex string: string empty."};
+    }
+
+    logger->trace(fnname + ": successful conversion to raw byte buffer.");
+
+    return decode_messageframe_bytes( ctx, parent );
+}
+
+/**
+ * Decode the ctx.messageframe_pdu type (a MessageFrame unless the input named another PDU) in ctx.byte_buffer and
+ * append its XML form to parent. The XML is built from the decoded structure directly; it is the document XER encoding
+ * would produce, without the XER text and a second parse.
+ */
+bool ASN1_Codec::decode_messageframe_bytes( CodecContext& ctx, pugi::xml_node& parent ) {
+    const std::string fnname = "decode_messageframe_bytes()";
+    const asn_TYPE_descriptor_t* td = ctx.messageframe_pdu;
+
+    void *pdu = decode_pdu( ctx, td, ctx.decode_messageframe_type );          // throws.
+
+    if ( bsm_batches ) collect_bsm( ctx, td, pdu );
+
+    // only the projected parts of the structure are written; the rest is skipped while writing.
+    auto projected = projections.find( td );
+    const Projection* projection = projected == projections.end() ? nullptr : &projected->second;
+
+    if ( output_format != OutputFormat::XML ) {
+        // written straight from the structure; write_output puts it in parent's place.
+        bool json = output_format == OutputFormat::JSON;
+        ctx.encoded_payload.clear();
+        bool written = json ? ctx.json_writer.append( ctx.encoded_payload, td, pdu, projection )
+                            : ctx.cbor_writer.append( ctx.encoded_payload, td, pdu, projection );
+        free_pdu( ctx, td, pdu );
+
+        if ( !written ) {
+            const asn_TYPE_descriptor_t* failed = json ? ctx.json_writer.failed_type() : ctx.cbor_writer.failed_type();
+            ctx.erroross.str("");
+            ctx.erroross << "failed ASN.1 " << ( json ? "JSON" : "CBOR" ) << " encoding of " << td->name << " element " << failed->name;
+            throw Asn1CodecError{ ctx.erroross.str() };
+        }
+
+        ctx.encoded_payload_node = parent;
+        logger->trace(fnname + ": finished.");
+        return true;
+    }
+
+    pugi::xml_node pdu_node = ctx.dom_builder.append( parent, td, pdu, projection );
+
+    free_pdu( ctx, td, pdu );
+
+    if ( !pdu_node ) {
+        ctx.erroross.str("");
+        ctx.erroross << "failed ASN.1 XML encoding of " << td->name << " element " << ctx.dom_builder.failed_type()->name;
+        throw Asn1CodecError{ ctx.erroross.str() };
+    }
+
+    logger->trace(fnname + ": finished.");
+    return true;
+}
+
+/**
+ * Decode ctx.byte_buffer as the given ASN.1 type and check the result against the type's constraints; this is the one
+ * binary decoder for every PDU in the registry.
+ *
+ * Return the decoded structure; the caller must release it with free_pdu.
+ */
+
+// throws Asn1CodecError ONLY!
+void* ASN1_Codec::decode_pdu( CodecContext& ctx, const asn_TYPE_descriptor_t* td, enum asn_transfer_syntax ats ) {
+    const std::string fnname = "decode_pdu()";
+
     // enum asn_dec_rval_code_e {
     // 	RC_OK,		                                  // successful decoding.
     // 	RC_WMORE,	                                  // more data expected.
@@ -1249,336 +1756,490 @@ bool ASN1_Codec::decode_1609dot2_data( std::string& data_as_hex, buffer_structur
     // } asn_dec_rval_t;
     asn_dec_rval_t decode_rval;
 
-    // typedef struct asn_enc_rval_s {
-    // 	ssize_t encoded;                              // bytes encoded on success; -1 on fail
-    // 	struct asn_TYPE_descriptor_s *failed_type;    // the type that failed.
-    // 	      ->name  
-    // 	void *structure_ptr;                          // pointer to structure of that type.
-    // } asn_enc_rval_t;
-    asn_enc_rval_t encode_rval;
-
-    errlen = max_errbuf_size;
-
-    Ieee1609Dot2Data_t *ieee1609data = 0;        // must initialize to 0 according to asn.1 instructions.
-
-    logger->trace(fnname + ": starting...");
-
-    // remove all spaces.
-    data_as_hex.erase( remove_if ( data_as_hex.begin(), data_as_hex.end(), isspace), data_as_hex.end());
+    ctx.errlen = CodecContext::max_errbuf_size;
 
-    if (data_as_hex.empty()) {
-        throw Asn1CodecError{"failed attempt to decode IEEE 1609.2 hex string: string empty."};
-    }
+    void *pdu = 0;                              // must initialize to 0 according to asn.1 instructions.
 
-    logger->trace(fnname + ": success extracting " + asn_DEF_Ieee1609Dot2Data.name + " hex string: " + data_as_hex );
+    // everything the skeleton allocates for this structure comes from the worker's arena, in use only while it decodes;
+    // see free_pdu().
+    if ( ctx.arena ) asn_arena_reset( ctx.arena );
 
-    byte_buffer.clear();
-    if (!hex_to_bytes_(data_as_hex, byte_buffer)) {
-        throw Asn1CodecError{"failed attempt to decode IEEE 1609.2 hex string: cannot convert to bytes."};
+    {
+        ArenaScope arena_scope{ ctx.arena };
+        decode_rval = asn_decode( 
+                0, 
+                ats, 
+                td,
+                &pdu,
+                ctx.byte_buffer.data(), 
+                ctx.byte_buffer.size() 
+                );
     }
 
-    logger->trace(fnname + ": successful conversion to raw byte buffer." );
-
-    // Decode BAH Bytes (A 1609.2 Frame) into the appropriate structure.
-    decode_rval = asn_decode( 
-            0, 
-            decode_1609dot2_type, 
-            &asn_DEF_Ieee1609Dot2Data, 
-            (void **)&ieee1609data, 
-            byte_buffer.data(), 
-            byte_buffer.size() 
-            );
-
     if ( decode_rval.code != RC_OK ) {
-        erroross.str("");
-        erroross << "failed ASN.1 binary decoding of element " << asn_DEF_Ieee1609Dot2Data.name << ": ";
+        ctx.erroross.str("");
+        ctx.erroross << "failed ASN.1 binary decoding of element " << td->name << ": ";
         if ( decode_rval.code == RC_FAIL ) {
-            erroross << "bad data.";
+            ctx.erroross << "bad data.";
         } else {
-            erroross << "more data expected.";
+            ctx.erroross << "more data expected.";
         }
-        erroross << " Successfully decoded " << decode_rval.consumed << " bytes.";
-        throw Asn1CodecError{ erroross.str() };
+        ctx.erroross << " Successfully decoded " << decode_rval.consumed << " bytes.";
+        free_pdu( ctx, td, pdu );
+        throw Asn1CodecError{ ctx.erroross.str() };
     }
 
-    logger->trace(fnname + ": ASN.1 binary decode success." );
+    logger->trace(fnname + ": ASN.1 binary decode of " + td->name + " successful.");
 
-    // check the data in the returned structure against the ASN.1 specification constraints.
-    if (asn_check_constraints( &asn_DEF_Ieee1609Dot2Data, ieee1609data, errbuf, &errlen )) {
-        erroross.str("");
-        erroross << "failed ASN.1 constraints check of element " << asn_DEF_Ieee1609Dot2Data.name << ": ";
-        erroross.write( errbuf, errlen );
-        ASN_STRUCT_FREE(asn_DEF_Ieee1609Dot2Data, ieee1609data);
-        throw Asn1CodecError{ erroross.str() };
+    // check the data in the returned structure against the ASN.1 specification constraints, as its policy says.
+    if (!check_constraints( ctx, td, pdu, false )) {
+        ctx.erroross.str("");
+        ctx.erroross << "failed ASN.1 constraints check of element " << td->name << ": ";
+        ctx.erroross.write( ctx.errbuf, ctx.errlen );
+        free_pdu( ctx, td, pdu );
+        throw Asn1CodecError{ ctx.erroross.str() };
     }
 
-    // target form is always XML (for now).
-    encode_rval = xer_encode( 
-            &asn_DEF_Ieee1609Dot2Data, 
-            ieee1609data, 
-            XER_F_CANONICAL, 
-            dynamic_buffer_append, 
-            static_cast<void *>(xml_buffer) 
-            );
+    return pdu;
+}
+
+/**
+ * Check a structure against its type's constraints when the type's policy asks for it; the outcome is counted.
+ *
+ * @return false if the structure was checked and violates a constraint; ctx.errbuf says why.
+ */
+bool ASN1_Codec::check_constraints( CodecContext& ctx, const asn_TYPE_descriptor_t* td, const void* sptr, bool encoding ) {
+    auto it = constraint_policies.find( td );
+    const ConstraintPolicy& policy = it == constraint_policies.end() ? default_constraint_policy : it->second;
+
+    switch ( policy.mode ) {
+        case ConstraintPolicy::Mode::OFF:
+            return true;
+
+        case ConstraintPolicy::Mode::ENCODE:
+            if ( !encoding ) return true;
+            break;
 
-    ASN_STRUCT_FREE(asn_DEF_Ieee1609Dot2Data, ieee1609data);
+        case ConstraintPolicy::Mode::SAMPLE:
+            if ( !encoding ) {
+                // counted per worker, so no worker waits on another.
+                uint32_t& since = ctx.constraint_samples[ td ];
+                if ( ++since < policy.sample_interval ) return true;
+                since = 0;
+            }
+            break;
 
-    if ( encode_rval.encoded == -1 ) {
-        erroross.str("");
-        erroross << "failed ASN.1 XML encoding of Ieee1609Dot2Data element " << encode_rval.failed_type->name;
-        throw Asn1CodecError{ erroross.str() };
+        case ConstraintPolicy::Mode::ALWAYS:
+            break;
     }
 
-    logger->trace(fnname + ": finished.");
-    return true;
+    constraint_checks++;
+    if ( asn_check_constraints( td, sptr, ctx.errbuf, &ctx.errlen ) == 0 ) return true;
+
+    constraint_violations++;
+    return false;
 }
 
 /**
- * TODO: This method should be generalizable to any type def and structure pointer -- tried but moved on.
+ * Add the core data of a decoded MessageFrame's BSM to the context's columnar batch.
  */
-bool ASN1_Codec::decode_messageframe_data( std::string& data_as_hex, buffer_structure_t* xml_buffer ) {
-    const std::string fnname = "decode_messageframe_data()";
-
-    asn_dec_rval_t decode_rval;
-    asn_enc_rval_t encode_rval;
+void ASN1_Codec::collect_bsm( CodecContext& ctx, const asn_TYPE_descriptor_t* td, const void* pdu ) {
+    if ( td != &asn_DEF_MessageFrame ) return;
 
-    errlen = max_errbuf_size;
+    const MessageFrame_t* frame = static_cast<const MessageFrame_t*>( pdu );
+    if ( frame->value.present != MessageFrame__value_PR_BasicSafetyMessage ) return;
 
-    MessageFrame_t *messageframe = 0;           // must be initialized to 0.
+    ctx.bsm_batch.append( frame->value.choice.BasicSafetyMessage.coreData );
+    flush_bsm_batch( ctx, false );
+}
 
-    logger->trace(fnname + ": starting...");
+/**
+ * Write the context's BSM batch to the configured directory and topic once it has bsm_batch_rows rows or its first row
+ * is bsm_batch_age old; with force, whenever it has any rows. A batch that cannot be written is logged and dropped, since
+ * the messages it came from have been published on their own.
+ */
+void ASN1_Codec::flush_bsm_batch( CodecContext& ctx, bool force ) {
+    const std::string fnname = "flush_bsm_batch()";
 
-    // remove all spaces.
-    data_as_hex.erase( remove_if ( data_as_hex.begin(), data_as_hex.end(), isspace), data_as_hex.end());
+    if ( ctx.bsm_batch.empty() ) return;
 
-    if (data_as_hex.empty()) {
-        throw Asn1CodecError{"failed attempt to decode MessageFrame hex string: string empty."};
+    if ( !force && ctx.bsm_batch.rows() < bsm_batch_rows && std::chrono::steady_clock::now() - ctx.bsm_batch.started() < bsm_batch_age ) {
+        return;
     }
 
-    logger->trace(fnname + ": success extracting " + asn_DEF_MessageFrame.name + " hex string: " + data_as_hex);
+    std::size_t rows = ctx.bsm_batch.rows();
+    uint64_t sequence = bsm_batch_count++;
+    bsm_batch_row_count += rows;
 
-    byte_buffer.clear();
-    if (!hex_to_bytes_(data_as_hex, byte_buffer)) {
-        throw Asn1CodecError{"failed attempt to decode MessageFrame hex string: cannot convert to bytes."};
-    }
+    ctx.bsm_batch.write( ctx.bsm_batch_output );
+    ctx.bsm_batch.clear();
 
-    logger->trace(fnname + ": successful conversion to raw byte buffer.");
+    if ( !bsm_batch_directory.empty() ) {
+        // written under another name and renamed, so readers of the directory never see a partial batch.
+        auto now = std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::system_clock::now().time_since_epoch() );
+        std::string path = bsm_batch_directory + "/bsm-" + std::to_string( now.count() ) + "-" + std::to_string( sequence ) + ".acmcol";
+        std::string partial = path + ".partial";
 
-    decode_rval = asn_decode( 
-            0, 
-            decode_messageframe_type, 
-            &asn_DEF_MessageFrame,
-            (void **)&messageframe,
-            byte_buffer.data(), 
-            byte_buffer.size() 
-            );
+        std::ofstream file{ partial, std::ios::binary };
+        file.write( ctx.bsm_batch_output.data(), ctx.bsm_batch_output.size() );
+        file.close();
 
-    if ( decode_rval.code != RC_OK ) {
-        erroross.str("");
-        erroross << "failed ASN.1 binary decoding of element " << asn_DEF_MessageFrame.name << ": ";
-        if ( decode_rval.code == RC_FAIL ) {
-            erroross << "bad data.";
-        } else {
-            erroross << "more data expected.";
+        if ( !file || std::rename( partial.c_str(), path.c_str() ) != 0 ) {
+            logger->error(fnname + ": cannot write a batch of " + std::to_string(rows) + " BSMs to " + path);
+            std::remove( partial.c_str() );
         }
-        erroross << " Successfully decoded " << decode_rval.consumed << " bytes.";
-        throw Asn1CodecError{ erroross.str() };
     }
 
-    logger->trace(fnname + ": ASN.1 binary decode successful.");
+    if ( bsm_batch_topic_ptr ) {
+        // copied, since the context reuses the buffer; the opaque tells the delivery report this is not an output.
+        RdKafka::ErrorCode status = producer_ptr->produce( bsm_batch_topic_ptr.get(), RdKafka::Topic::PARTITION_UA, RdKafka::Producer::RK_MSG_COPY,
+                const_cast<char*>( ctx.bsm_batch_output.data() ), ctx.bsm_batch_output.size(), NULL, &bsm_batch_count );
 
-    if (asn_check_constraints( &asn_DEF_MessageFrame, messageframe, errbuf, &errlen )) {
-        erroross.str("");
-        erroross << "failed ASN.1 constraints check of element " << asn_DEF_MessageFrame.name << ": ";
-        erroross.write( errbuf, errlen );
-        ASN_STRUCT_FREE(asn_DEF_MessageFrame, messageframe);
-        throw Asn1CodecError{ erroross.str() };
+        if ( status != RdKafka::ERR_NO_ERROR ) {
+            logger->error(fnname + ": cannot queue a batch of " + std::to_string(rows) + " BSMs for topic " + bsm_batch_topic + ": " + RdKafka::err2str(status));
+        }
     }
 
-    // Encode the Ieee1609Dot2Data ASN.1 C struct into XML, so we can extract out the BSM.
-    encode_rval = xer_encode( 
-            &asn_DEF_MessageFrame, 
-            messageframe, 
-            XER_F_CANONICAL, 
-            dynamic_buffer_append, 
-            static_cast<void *>(xml_buffer) 
-            );
-
-    ASN_STRUCT_FREE(asn_DEF_MessageFrame, messageframe);
+    logger->trace(fnname + ": wrote a batch of " + std::to_string(rows) + " BSMs.");
+}
 
-    if ( encode_rval.encoded == -1 ) {
-        erroross.str("");
-        erroross << "failed ASN.1 XML encoding of MessageFrame element " << encode_rval.failed_type->name;
-        throw Asn1CodecError{ erroross.str() };
+/**
+ * Release a structure from decode_pdu or xer_decode. With an arena its memory is given back in one reset instead of
+ * walking the structure; if the skeleton did not allocate from the arena (libasncodec built without asn_arena.h) the
+ * structure is freed the usual way.
+ */
+void ASN1_Codec::free_pdu( CodecContext& ctx, const asn_TYPE_descriptor_t* td, void* pdu ) {
+    if ( ctx.arena && asn_arena_used( ctx.arena ) > 0 ) {
+        asn_arena_reset( ctx.arena );
+        return;
     }
 
-    logger->trace(fnname + ": finished.");
-    return true;
+    ASN_STRUCT_FREE(*td, pdu);
 }
         
-void ASN1_Codec::encode_frame_data(const std::string& data_as_xml, std::string& hex_string) {
+void ASN1_Codec::encode_frame_data( CodecContext& ctx, const asn_TYPE_descriptor_t* data_struct, enum asn_transfer_syntax syntax, const std::string& data_as_xml, std::string& hex_string ) {
     const std::string fnname = "encode_frame_data()";
 
     asn_dec_rval_t decode_rval;
     asn_enc_rval_t encode_rval;
 
-	// TODO: working toward a general solution for these function; first is passing in a ref to 
-	// these types of structures.
-	struct asn_TYPE_descriptor_s* data_struct;
     void *frame_data = 0;
 
-    switch (curr_op_) {
-        case J2735MESSAGEFRAME:
-            data_struct = &asn_DEF_MessageFrame;
-
-            break;
-        case IEEE1609DOT2:
-            data_struct = &asn_DEF_Ieee1609Dot2Data;
+    ctx.errlen = CodecContext::max_errbuf_size;
 
-            break;
-        case ASDFRAME:
-            data_struct = &asn_DEF_AdvisorySituationData;
+    if ( ctx.arena ) asn_arena_reset( ctx.arena );
 
-            break;
-        default:
-            // TODO internal err
-            break;
+    {
+        ArenaScope arena_scope{ ctx.arena };
+        decode_rval = xer_decode( 
+                0 				// new parameter addition seems to work with nullptr.
+                , data_struct
+                , (void **)&frame_data
+                , data_as_xml.data()
+                , data_as_xml.size()
+                );
     }
 
-    errlen = max_errbuf_size;
-
-    decode_rval = xer_decode( 
-            0 				// new parameter addition seems to work with nullptr.
-			, data_struct
-            , (void **)&frame_data
-            , data_as_xml.data()
-            , data_as_xml.size()
-            );
-
     if ( decode_rval.code != RC_OK ) {
-        erroross.str("");
-        erroross << "failed ASN.1 decoding of XML element " << data_struct->name << ": ";
+        ctx.erroross.str("");
+        ctx.erroross << "failed ASN.1 decoding of XML element " << data_struct->name << ": ";
         if ( decode_rval.code == RC_FAIL ) {
-            erroross << "bad data.";
+            ctx.erroross << "bad data.";
         } else {
-            erroross << "more data expected.";
+            ctx.erroross << "more data expected.";
         }
-        erroross << " Successfully decoded " << decode_rval.consumed << " bytes.";
-        throw Asn1CodecError{ erroross.str() };
+        ctx.erroross << " Successfully decoded " << decode_rval.consumed << " bytes.";
+        free_pdu( ctx, data_struct, frame_data );
+        throw Asn1CodecError{ ctx.erroross.str() };
     }
 
-    if (asn_check_constraints( data_struct, frame_data, errbuf, &errlen )) {
-        erroross.str("");
-        erroross << "failed ASN.1 constraints check of element " << data_struct->name << ": ";
-        erroross.write( errbuf, errlen );
-        ASN_STRUCT_FREE(*data_struct, frame_data);
-        throw Asn1CodecError{ erroross.str() };
+    if (!check_constraints( ctx, data_struct, frame_data, true )) {
+        ctx.erroross.str("");
+        ctx.erroross << "failed ASN.1 constraints check of element " << data_struct->name << ": ";
+        ctx.erroross.write( ctx.errbuf, ctx.errlen );
+        free_pdu( ctx, data_struct, frame_data );
+        throw Asn1CodecError{ ctx.erroross.str() };
     }
 
-    buffer_structure_t buffer = {0,0,0};
+    // the worker's buffer is already large enough for this type in the steady state.
+    ctx.encode_buffer.prepare( data_struct );
 
     encode_rval = asn_encode(
         0,
-        curr_decode_type_,
+        syntax,
         data_struct,
         frame_data, 
-        dynamic_buffer_append, 
-        static_cast<void *>(&buffer) 
+        EncodeBuffer::append, 
+        static_cast<void *>(&ctx.encode_buffer) 
         );
 
-    ASN_STRUCT_FREE(*data_struct, frame_data);
+    free_pdu( ctx, data_struct, frame_data );
 
     if ( encode_rval.encoded == -1 ) {
-        erroross.str("");
-        erroross << "failed ASN.1 encoding of SDWTIM element " << encode_rval.failed_type->name;
-        throw Asn1CodecError{ erroross.str() };
+        ctx.erroross.str("");
+        ctx.erroross << "failed ASN.1 encoding of " << data_struct->name << " element " << encode_rval.failed_type->name;
+        throw Asn1CodecError{ ctx.erroross.str() };
     }
 
-    if (!bytes_to_hex_(&buffer, hex_string)) {
-        std::free( static_cast<void *>(buffer.buffer) );
+    ctx.encode_buffer.finish( data_struct );
+
+    if (!bytes_to_hex_(ctx.encode_buffer.data(), ctx.encode_buffer.size(), hex_string)) {
         throw Asn1CodecError{ "failed attempt to encode SDWTIM byte buffer into hex string." };
     }
-
-    std::free( static_cast<void *>(buffer.buffer) );
 }
 
-bool ASN1_Codec::set_codec_requirements( pugi::xml_document& doc ) {
+bool ASN1_Codec::set_codec_requirements( CodecContext& ctx ) {
     const std::string fnname = "set_codec_requirements()";
 
-    enum asn_transfer_syntax atstype = ATS_INVALID;
-	opsflag = 0;
+    // Determine which decodings are needed.
+    pugi::xml_node encodings = ctx.input_doc.child("OdeAsn1Data").child("metadata").child("encodings");
+    if (!encodings) {
+        throw UnparseableInputError{"Failed to find path: OdeAsn1Data/metadata/encodings in the input file."};
+    }
+
+    // the plan only depends on the elementType and encodingRule of each entry.
+    ctx.plan_key.clear();
+    for ( pugi::xml_node n = encodings.first_child(); n; n = n.next_sibling()) {
+        ctx.plan_key.append( n.child("elementType").text().get() );
+        ctx.plan_key.push_back( '\0' );
+        ctx.plan_key.append( n.child("encodingRule").text().get() );
+        ctx.plan_key.push_back( '\0' );
+    }
+
+    select_plan( ctx );
+    return true;
+}
 
-    // re-establish defaults.
-    decode_1609dot2 = false;
-    decode_messageframe = false;
-    decode_asdframe = false;
-    decode_1609dot2_type = ATS_CANONICAL_OER;
-    decode_messageframe_type = ATS_UNALIGNED_BASIC_PER;
+/**
+ * Set the requirements of a raw record from its encodings header, or from its pipeline's input encodings when it has
+ * none; both are lists of elementType:encodingRule, outermost first.
+ */
+bool ASN1_Codec::set_raw_codec_requirements( CodecContext& ctx, RdKafka::Message* message, const Pipeline& pipeline ) {
+    RdKafka::Headers* headers = message->headers();
+
+    if ( headers ) {
+        RdKafka::Headers::Header header = headers->get_last( "encodings" );
+        if ( header.value() ) {
+            std::string list{ static_cast<const char*>( header.value() ), header.value_size() };
+            if ( !encodings_plan_key( list, ctx.plan_key ) ) {
+                throw UnparseableInputError{ "Malformed encodings header: " + list };
+            }
 
+            select_plan( ctx );
+            return true;
+        }
+    }
 
-    // Determine which decodings are needed.
-    // TODO: Think aobut using a xpath_nodeset structure and iterating.
-    pugi::xpath_node encodings_xpath_node = ode_encodings_query.evaluate_node( input_doc );
-    if (!encodings_xpath_node) {
-        throw UnparseableInputError{"Failed to find path: OdeAsn1Data/metadata/encodings in the input file."};
+    if ( pipeline.raw_plan_key.empty() ) {
+        throw UnparseableInputError{ "Raw input record has no encodings header and its pipeline has no input encodings." };
     }
 
-    for ( pugi::xml_node n = encodings_xpath_node.node().first_child(); n; n = n.next_sibling()) {
+    ctx.plan_key = pipeline.raw_plan_key;
+    select_plan( ctx );
+    return true;
+}
+
+/**
+ * Find (or compile and cache) the plan for ctx.plan_key and copy its requirements into the context.
+ */
+void ASN1_Codec::select_plan( CodecContext& ctx ) {
+    auto it = ctx.plans.find( ctx.plan_key );
+    if ( it == ctx.plans.end() ) {
+        CodecPlan plan = compile_plan( ctx.plan_key );      // throws UnparseableInputErrors; those are not cached.
+
+        if ( ctx.plans.size() >= CodecContext::max_plans ) {
+            ctx.plans.clear();
+        }
+        it = ctx.plans.emplace( ctx.plan_key, std::move( plan ) ).first;
+    }
+
+    const CodecPlan& plan = it->second;
+    ctx.plan = &plan;
+    ctx.opsflag = plan.opsflag;
+    ctx.decode_1609dot2 = plan.decode_1609dot2;
+    ctx.decode_messageframe = plan.decode_messageframe;
+    ctx.decode_asdframe = plan.decode_asdframe;
+    ctx.decode_1609dot2_type = plan.decode_1609dot2_type;
+    ctx.decode_messageframe_type = plan.decode_messageframe_type;
+    ctx.decode_asdframe_type = plan.decode_asdframe_type;
+    ctx.messageframe_pdu = plan.messageframe_pdu;
+}
+
+/**
+ * Work out what an encodings block asks for: which layers to decode and with which rules, and the nodes to encode
+ * (innermost first) with their paths split into names. The block is given as its plan key: the elementType and
+ * encodingRule of every entry, each followed by a NUL.
+ */
+CodecPlan ASN1_Codec::compile_plan( const std::string& plan_key ) {
+    CodecPlan plan;
+    enum asn_transfer_syntax atstype = ATS_INVALID;
 
-        pugi::xml_text ats_node = n.child("encodingRule").text();
-        if ( ats_node ) {
+    for ( const char* p = plan_key.c_str(); p < plan_key.c_str() + plan_key.size(); ) {
+        const char* element_type = p;
+        p += std::strlen( p ) + 1;
+        const char* encoding_rule = p;
+        p += std::strlen( p ) + 1;
+
+        if ( *encoding_rule ) {
             // the XML file contains the rule specification and we should use it.
-            atstype = get_ats_transfer_syntax( ats_node.get() );
+            atstype = get_ats_transfer_syntax( encoding_rule );
         }
 
 		if ( atstype == ATS_INVALID ) {
 			throw UnparseableInputError{"Invalid encoding rule in input file."};
 		}
-        
-        // TODO: These strings ( must be detected as hard coded string or config parameters ).
 
-        if ( std::strcmp(n.child("elementType").text().get(), "Ieee1609Dot2Data") == 0 ) {
-			opsflag |= static_cast<uint32_t>(Asn1OpsType::IEEE1609DOT2);
-            decode_1609dot2 = true;
-            decode_1609dot2_type = atstype;
+        // types this module does not know are ignored, as before.
+        const asn_TYPE_descriptor_t* td = asn1_types.find( element_type );
+        if ( !td ) continue;
 
-        } else if ( std::strcmp(n.child("elementType").text().get(), "MessageFrame") == 0 ) {
-			opsflag |= static_cast<uint32_t>(Asn1OpsType::J2735MESSAGEFRAME);
-            decode_messageframe = true;
-            decode_messageframe_type = atstype;
+        if ( td == &asn_DEF_Ieee1609Dot2Data ) {
+			plan.opsflag |= static_cast<uint32_t>(Asn1OpsType::IEEE1609DOT2);
+            plan.decode_1609dot2 = true;
+            plan.decode_1609dot2_type = atstype;
 
-        } else if ( std::strcmp(n.child("elementType").text().get(), "AdvisorySituationData") == 0 ) {
-			opsflag |= static_cast<uint32_t>(Asn1OpsType::ASDFRAME);
-            decode_asdframe = true;
-            decode_asdframe_type = atstype;
+        } else if ( td == &asn_DEF_AdvisorySituationData ) {
+			plan.opsflag |= static_cast<uint32_t>(Asn1OpsType::ASDFRAME);
+            plan.decode_asdframe = true;
+            plan.decode_asdframe_type = atstype;
+
+        } else {
+            // a MessageFrame, or any other PDU (e.g., SPAT or MapData on its own), takes the MessageFrame's place.
+			plan.opsflag |= static_cast<uint32_t>(Asn1OpsType::J2735MESSAGEFRAME);
+            plan.decode_messageframe = true;
+            plan.decode_messageframe_type = atstype;
+            plan.messageframe_pdu = td;
         }
     }
 
-    if (!opsflag) {
+    if (!plan.opsflag) {
         throw UnparseableInputError{"Input file did not specify any encoding/decoding operations."};
     }
 
-    return true;
-}
+    auto add_step = [&plan]( const asn_TYPE_descriptor_t* type, enum asn_transfer_syntax syntax, const std::string& path, bool replace ) {
+        plan.encode_steps.push_back( CodecPlan::EncodeStep{ type, syntax, path, string_utilities::split( path, '/' ), replace } );
+    };
 
-bool ASN1_Codec::file_test(std::string file_path, std::ostream& os, bool encode) {
-    const std::string fnname = "file_test()";
+    const asn_TYPE_descriptor_t* frame_type = plan.messageframe_pdu;
+    const asn_TYPE_descriptor_t* ieee_type = &asn_DEF_Ieee1609Dot2Data;
+    const asn_TYPE_descriptor_t* asd_type = &asn_DEF_AdvisorySituationData;
+    const std::string frame{ frame_type->xml_tag };
 
-    std::stringstream output_msg_stream;
-    bool r = true;
+    plan.encodable = true;
+    switch (plan.opsflag) {
+        case IEEE1609DOT2:
+            add_step( ieee_type, plan.decode_1609dot2_type, "Ieee1609Dot2Data", false );
 
-    std::FILE* ifile = std::fopen( file_path.c_str(), "r" );
+            break;
+        case J2735MESSAGEFRAME:
+            add_step( frame_type, plan.decode_messageframe_type, frame, false );
 
-    if (!ifile) {
-        logger->error(fnname + ": cannot open " + file_path);
-        return EXIT_FAILURE;
-    }
+            break;
+        case IEEE1609DOT2_J2735MESSAGEFRAME:
+            add_step( frame_type, plan.decode_messageframe_type, "Ieee1609Dot2Data/content/unsecuredData/" + frame, true );
+            add_step( ieee_type, plan.decode_1609dot2_type, "Ieee1609Dot2Data", false );
 
-    decode_functionality = !encode;
+            break;
+        case ASDFRAME:
+            add_step( asd_type, plan.decode_asdframe_type, "AdvisorySituationData", false );
 
-    // compute file size in bytes.
-    std::fseek(ifile, 0, SEEK_END);
-    std::size_t ifile_size = std::ftell(ifile);
+            break;
+        case ASDFRAME_IEEE1609DOT2:
+            add_step( ieee_type, plan.decode_1609dot2_type, "AdvisorySituationData/asdmDetails/advisoryMessage/Ieee1609Dot2Data", true );
+            add_step( asd_type, plan.decode_asdframe_type, "AdvisorySituationData", false );
+
+            break;
+        case ASDFRAME_J2735MESSAGEFRAME:
+            add_step( frame_type, plan.decode_messageframe_type, "AdvisorySituationData/asdmDetails/advisoryMessage/" + frame, true );
+            add_step( asd_type, plan.decode_asdframe_type, "AdvisorySituationData", false );
+
+            break;
+        case ASDFRAME_IEEE1609DOT2_J2735MESSAGEFRAME:
+            add_step( frame_type, plan.decode_messageframe_type, "AdvisorySituationData/asdmDetails/advisoryMessage/Ieee1609Dot2Data/content/unsecuredData/" + frame, true );
+            add_step( ieee_type, plan.decode_1609dot2_type, "AdvisorySituationData/asdmDetails/advisoryMessage/Ieee1609Dot2Data", true );
+            add_step( asd_type, plan.decode_asdframe_type, "AdvisorySituationData", false );
+
+            break;
+        default:
+            // reported by encode_message; decoding does not need steps.
+            plan.encodable = false;
+    }
+
+    return plan;
+}
+
+/**
+ * Locate the parts of the input that processing will change (the payload data and its dataType) so write_output can
+ * copy the rest of the input instead of serializing the whole document. Call this before the document is modified; the
+ * input must stay alive until write_output.
+ */
+void ASN1_Codec::prepare_output( CodecContext& ctx, const void* input, std::size_t size ) const {
+    if ( output_format != OutputFormat::XML ) {
+        // nothing of the input text is reused.
+        ctx.output_splice.reset( nullptr, 0 );
+        return;
+    }
+
+    ctx.output_splice.reset( static_cast<const char*>( input ), size );
+    ctx.output_splice.replace_content( ctx.payload_node_ );
+    ctx.output_splice.replace_content( ctx.payload_node_.parent().child("dataType") );
+}
+
+/**
+ * Write the processed document: the input with the payload spliced in when possible; otherwise the DOM in its RAW
+ * string representation: no spaces, no tabs.
+ */
+void ASN1_Codec::write_output( CodecContext& ctx, pugi::xml_writer& output ) const {
+    if ( output_format == OutputFormat::JSON ) {
+        asn1_json::write_document( ctx.input_doc, output, ctx.encoded_payload_node, ctx.encoded_payload );
+    } else if ( output_format == OutputFormat::CBOR ) {
+        asn1_cbor::write_document( ctx.input_doc, output, ctx.encoded_payload_node, ctx.encoded_payload );
+    } else if ( ctx.output_splice.valid() ) {
+        ctx.output_splice.write( output );
+    } else {
+        ctx.input_doc.save( output, "", pugi::format_raw );
+    }
+
+    ctx.output_splice.reset( nullptr, 0 );
+    ctx.encoded_payload_node = pugi::xml_node{};
+}
+
+/**
+ * Write a whole document (an error response) in the output format.
+ */
+void ASN1_Codec::write_document( CodecContext& ctx, const pugi::xml_document& doc, pugi::xml_writer& output ) const {
+    if ( output_format == OutputFormat::JSON ) {
+        asn1_json::write_document( doc, output );
+    } else if ( output_format == OutputFormat::CBOR ) {
+        asn1_cbor::write_document( doc, output );
+    } else {
+        doc.save( output, "", pugi::format_raw );
+    }
+
+    ctx.output_splice.reset( nullptr, 0 );
+    ctx.encoded_payload_node = pugi::xml_node{};
+}
+
+bool ASN1_Codec::file_test(std::string file_path, std::ostream& os, bool encode) {
+    const std::string fnname = "file_test()";
+    CodecContext& ctx = main_context;
+
+    std::stringstream output_msg_stream;
+    pugi::xml_writer_stream output_msg_writer{ output_msg_stream };
+    bool r = true;
+
+    std::FILE* ifile = std::fopen( file_path.c_str(), "r" );
+
+    if (!ifile) {
+        logger->error(fnname + ": cannot open " + file_path);
+        return EXIT_FAILURE;
+    }
+
+    decode_functionality = !encode;
+
+    // compute file size in bytes.
+    std::fseek(ifile, 0, SEEK_END);
+    std::size_t ifile_size = std::ftell(ifile);
     std::fseek(ifile, 0, SEEK_SET);
 
     std::vector<unsigned char> consumed_xml_buffer( ifile_size );
@@ -1592,57 +2253,59 @@ bool ASN1_Codec::file_test(std::string file_path, std::ostream& os, bool encode)
         try {
 
             // pugi resets the document as part of load_buffer
-            pugi::xml_parse_result result = input_doc.load_buffer((const void*) consumed_xml_buffer.data(), consumed_xml_buffer.size(), xml_parse_options );
+            pugi::xml_parse_result result = ctx.input_doc.load_buffer((const void*) consumed_xml_buffer.data(), consumed_xml_buffer.size(), xml_parse_options );
 
             if (!result) {
-                erroross.str("");
-                erroross << "Input file parse error: " << result.description() << " at offset " << result.offset;
-                throw UnparseableInputError{ erroross.str() };
+                ctx.erroross.str("");
+                ctx.erroross << "Input file parse error: " << result.description() << " at offset " << result.offset;
+                throw UnparseableInputError{ ctx.erroross.str() };
             } 
 
             // examine the input xml encodings information and set the flags and requirements needed to properly parse the byte strings.
-            set_codec_requirements( input_doc );            // throws.
+            set_codec_requirements( ctx );            // throws.
 
             // Retain this node reference. It is where the decoded result will be inserted.
 
-            payload_node_ = ode_payload_query.evaluate_node( input_doc ).node();
-            if ( !payload_node_ ) {
+            ctx.payload_node_ = ode_payload_query.evaluate_node( ctx.input_doc ).node();
+            if ( !ctx.payload_node_ ) {
                 throw UnparseableInputError{ "Failed to find path: OdeAsn1Data/payload/data in the input document." };
             } 
 
+            prepare_output( ctx, consumed_xml_buffer.data(), consumed_xml_buffer.size() );
+
             if ( decode_functionality ) {
-                decode_message( payload_node_, output_msg_stream );
+                decode_message( ctx, ctx.payload_node_, output_msg_writer );
             } else {
-                encode_message( output_msg_stream );
+                encode_message( ctx, output_msg_writer );
             }
 
         } catch (const UnparseableInputError& e) {
 
             r = false;
             logger->error(fnname + ": UnparseableInputError " + e.what());
-            add_error_xml( error_doc, e.data_type(), e.error_type(), e.what(), true );
-            error_doc.save(output_msg_stream,"",pugi::format_raw);
+            add_error_xml( ctx.error_doc, e.data_type(), e.error_type(), e.what(), true );
+            ctx.error_doc.save(output_msg_stream,"",pugi::format_raw);
 
         } catch (const MissingInputElementError& e) {
 
             r = false;
             logger->error(fnname + ": MissingInputElementError " + e.what() );
-            add_error_xml( error_doc, e.data_type(), e.error_type(), e.what(), true );
-            error_doc.save(output_msg_stream,"",pugi::format_raw);
+            add_error_xml( ctx.error_doc, e.data_type(), e.error_type(), e.what(), true );
+            ctx.error_doc.save(output_msg_stream,"",pugi::format_raw);
 
         } catch (const pugi::xpath_exception& e ) {
 
             r = false;
             logger->error(fnname + ": pugi::xpath_exception " + e.what() );
-            add_error_xml( error_doc, Asn1DataType::ODE, Asn1ErrorType::REQUEST, e.what(), true );
-            error_doc.save(output_msg_stream,"",pugi::format_raw);
+            add_error_xml( ctx.error_doc, Asn1DataType::ODE, Asn1ErrorType::REQUEST, e.what(), true );
+            ctx.error_doc.save(output_msg_stream,"",pugi::format_raw);
 
         } catch (const Asn1CodecError& e) {
 
             r = false;
             logger->error(fnname + ": Asn1CodecError " + e.what() );
-            add_error_xml( input_doc, e.data_type(), e.error_type(), e.what(), false );
-            input_doc.save(output_msg_stream,"",pugi::format_raw);
+            add_error_xml( ctx.input_doc, e.data_type(), e.error_type(), e.what(), false );
+            ctx.input_doc.save(output_msg_stream,"",pugi::format_raw);
         }
 
         os << output_msg_stream.str() << std::endl;
@@ -1657,11 +2320,13 @@ bool ASN1_Codec::file_test(std::string file_path, std::ostream& os, bool encode)
  */
 bool ASN1_Codec::filetest() {
     const std::string fnname = "filetest()";
+    CodecContext& ctx = main_context;
     bool r = true;
 
     std::string error_string;
     RdKafka::ErrorCode status;
     std::stringstream output_msg_stream;
+    pugi::xml_writer_stream output_msg_writer{ output_msg_stream };
 
     signal(SIGINT, sigterm);
     signal(SIGTERM, sigterm);
@@ -1702,57 +2367,59 @@ bool ASN1_Codec::filetest() {
         try {
 
             // pugi resets the document as part of load_buffer
-            pugi::xml_parse_result result = input_doc.load_buffer((const void*) consumed_xml_buffer.data(), consumed_xml_buffer.size(), xml_parse_options );
+            pugi::xml_parse_result result = ctx.input_doc.load_buffer((const void*) consumed_xml_buffer.data(), consumed_xml_buffer.size(), xml_parse_options );
 
             if (!result) {
-                erroross.str("");
-                erroross << "Input file parse error: " << result.description() << " at offset " << result.offset;
-                throw UnparseableInputError{ erroross.str() };
+                ctx.erroross.str("");
+                ctx.erroross << "Input file parse error: " << result.description() << " at offset " << result.offset;
+                throw UnparseableInputError{ ctx.erroross.str() };
             } 
 
             // examine the input xml encodings information and set the flags and requirements needed to properly parse the byte strings.
-            set_codec_requirements( input_doc );            // throws.
+            set_codec_requirements( ctx );            // throws.
 
             // Retain this node reference. It is where the decoded result will be inserted.
-            payload_node_ = ode_payload_query.evaluate_node( input_doc ).node();
+            ctx.payload_node_ = ode_payload_query.evaluate_node( ctx.input_doc ).node();
 
-            if ( !payload_node_ ) {
+            if ( !ctx.payload_node_ ) {
                 throw UnparseableInputError{ "Failed to find path: OdeAsn1Data/payload/data in the input document." };
             } 
 
+            prepare_output( ctx, consumed_xml_buffer.data(), consumed_xml_buffer.size() );
+
             if ( decode_functionality ) {
-                decode_message( payload_node_, output_msg_stream );
+                decode_message( ctx, ctx.payload_node_, output_msg_writer );
             } else {
-                encode_message( output_msg_stream );
+                encode_message( ctx, output_msg_writer );
             }
 
         } catch (const UnparseableInputError& e) {
 
             r = false;
             logger->error(fnname + ": UnparseableInputError " + std::string(e.what()));
-            add_error_xml( error_doc, e.data_type(), e.error_type(), e.what(), true );
-            error_doc.save(output_msg_stream,"",pugi::format_raw);
+            add_error_xml( ctx.error_doc, e.data_type(), e.error_type(), e.what(), true );
+            ctx.error_doc.save(output_msg_stream,"",pugi::format_raw);
 
         } catch (const MissingInputElementError& e) {
 
             r = false;
             logger->error(fnname + ": MissingInputElementError " + std::string(e.what()));
-            add_error_xml( error_doc, e.data_type(), e.error_type(), e.what(), true );
-            error_doc.save(output_msg_stream,"",pugi::format_raw);
+            add_error_xml( ctx.error_doc, e.data_type(), e.error_type(), e.what(), true );
+            ctx.error_doc.save(output_msg_stream,"",pugi::format_raw);
 
         } catch (const pugi::xpath_exception& e ) {
 
             r = false;
             logger->error(fnname + ": pugi::xpath_exception " + std::string(e.what()));
-            add_error_xml( error_doc, Asn1DataType::ODE, Asn1ErrorType::REQUEST, e.what(), true );
-            error_doc.save(output_msg_stream,"",pugi::format_raw);
+            add_error_xml( ctx.error_doc, Asn1DataType::ODE, Asn1ErrorType::REQUEST, e.what(), true );
+            ctx.error_doc.save(output_msg_stream,"",pugi::format_raw);
 
         } catch (const Asn1CodecError& e) {
 
             r = false;
             logger->error(fnname + ": Asn1CodecError " + std::string(e.what()));
-            add_error_xml( input_doc, e.data_type(), e.error_type(), e.what(), false );
-            input_doc.save(output_msg_stream,"",pugi::format_raw);
+            add_error_xml( ctx.input_doc, e.data_type(), e.error_type(), e.what(), false );
+            ctx.input_doc.save(output_msg_stream,"",pugi::format_raw);
 
         }
 
@@ -1769,14 +2436,959 @@ bool ASN1_Codec::filetest() {
     return r ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
+/**
+ * librdkafka interceptors that pin every thread a client starts (main, background, and broker threads) to the
+ * configured cpus. Thread interceptors can only be added to a client while it is created, so an on_new interceptor is
+ * placed on the configuration and carried onto every copy of it (the C++ API copies the configuration in create()).
+ * The opaque is the ACM's cpu list, which outlives the clients.
+ */
+static const char* affinity_interceptor_name = "acm-affinity";
+
+static rd_kafka_resp_err_t affinity_on_thread_start( rd_kafka_t* rk, rd_kafka_thread_type_t thread_type, const char* thread_name, void* ic_opaque ) {
+    affinity::pin_current_thread( *static_cast<const affinity::CpuList*>( ic_opaque ) );
+    return RD_KAFKA_RESP_ERR_NO_ERROR;
+}
+
+static rd_kafka_resp_err_t affinity_on_new( rd_kafka_t* rk, const rd_kafka_conf_t* conf, void* ic_opaque, char* errstr, size_t errstr_size ) {
+    return rd_kafka_interceptor_add_on_thread_start( rk, affinity_interceptor_name, affinity_on_thread_start, ic_opaque );
+}
+
+static rd_kafka_resp_err_t add_affinity_interceptors( rd_kafka_conf_t* conf, void* ic_opaque );
+
+static rd_kafka_resp_err_t affinity_on_conf_dup( rd_kafka_conf_t* new_conf, const rd_kafka_conf_t* old_conf, size_t filter_cnt, const char** filter, void* ic_opaque ) {
+    return add_affinity_interceptors( new_conf, ic_opaque );
+}
+
+static rd_kafka_resp_err_t add_affinity_interceptors( rd_kafka_conf_t* conf, void* ic_opaque ) {
+    rd_kafka_resp_err_t err = rd_kafka_conf_interceptor_add_on_new( conf, affinity_interceptor_name, affinity_on_new, ic_opaque );
+    if ( err == RD_KAFKA_RESP_ERR_NO_ERROR ) {
+        err = rd_kafka_conf_interceptor_add_on_conf_dup( conf, affinity_interceptor_name, affinity_on_conf_dup, ic_opaque );
+    }
+
+    // already present when the copy carried the interceptors over.
+    return err == RD_KAFKA_RESP_ERR__CONFLICT ? RD_KAFKA_RESP_ERR_NO_ERROR : err;
+}
+
+/**
+ * A sample:N interval must be between 1 and UINT32_MAX; a malformed one leaves the policy as it was.
+ */
+bool ConstraintPolicy::parse( const std::string& text ) {
+    if ( text == "always" ) {
+        mode = Mode::ALWAYS;
+    } else if ( text == "encode" ) {
+        mode = Mode::ENCODE;
+    } else if ( text == "off" ) {
+        mode = Mode::OFF;
+    } else if ( text.compare( 0, 7, "sample:" ) == 0 ) {
+        unsigned long interval = 0;
+        try {
+            interval = std::stoul( text.substr( 7 ) );
+        } catch( std::exception& e ) {
+            return false;
+        }
+        if ( interval < 1 || interval > UINT32_MAX ) return false;
+
+        mode = Mode::SAMPLE;
+        sample_interval = static_cast<uint32_t>( interval );
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Read the constraint checking policies: acm.constraints for every type, and acm.constraints.<type> (an ASN.1 type
+ * name, e.g., MessageFrame) for one type.
+ */
+bool ASN1_Codec::configure_constraints() {
+    const std::string fnname = "configure_constraints()";
+    const std::string prefix = "acm.constraints.";
+
+    auto search = pconf.find("acm.constraints");
+    if ( search != pconf.end() && !default_constraint_policy.parse( search->second ) ) {
+        logger->error(fnname + ": malformed acm.constraints: " + search->second);
+        return false;
+    }
+
+    for ( const auto& entry : pconf ) {
+        if ( entry.first.compare( 0, prefix.size(), prefix ) != 0 ) continue;
+
+        const std::string type_name = entry.first.substr( prefix.size() );
+        const asn_TYPE_descriptor_t* td = asn1_types.find( type_name );
+        if ( !td ) {
+            logger->error(fnname + ": " + entry.first + " names an unknown ASN.1 type.");
+            return false;
+        }
+
+        ConstraintPolicy policy;
+        if ( !policy.parse( entry.second ) ) {
+            logger->error(fnname + ": malformed " + entry.first + ": " + entry.second);
+            return false;
+        }
+
+        constraint_policies[ td ] = policy;
+        logger->info(fnname + ": constraint checking of " + type_name + ": " + entry.second);
+    }
+
+    return true;
+}
+
+/**
+ * Read the output projections: acm.projection.<type> (an ASN.1 type name, e.g., MessageFrame) is a comma separated
+ * list of the paths below the type's element that decoded output of that type keeps.
+ */
+bool ASN1_Codec::configure_projections() {
+    const std::string fnname = "configure_projections()";
+    const std::string prefix = "acm.projection.";
+
+    for ( const auto& entry : pconf ) {
+        if ( entry.first.compare( 0, prefix.size(), prefix ) != 0 ) continue;
+
+        const std::string type_name = entry.first.substr( prefix.size() );
+        const asn_TYPE_descriptor_t* td = asn1_types.find( type_name );
+        if ( !td ) {
+            logger->error(fnname + ": " + entry.first + " names an unknown ASN.1 type.");
+            return false;
+        }
+
+        Projection& projection = projections[ td ];
+        for ( std::string path : string_utilities::split( entry.second, ',' ) ) {
+            string_utilities::strip( path );
+            if ( !projection.add( path ) ) {
+                logger->error(fnname + ": malformed path in " + entry.first + ": " + path);
+                return false;
+            }
+        }
+
+        logger->info(fnname + ": decoded " + type_name + " output is projected to: " + entry.second);
+    }
+
+    return true;
+}
+
+/**
+ * Read the members the UPER decoder skips: acm.uper.skip.<type> (an ASN.1 type name, e.g., BasicSafetyMessage) is a
+ * comma separated list of paths to OPTIONAL members below the type. This changes the shared type descriptors, so it
+ * happens before any worker starts.
+ */
+bool ASN1_Codec::configure_uper_skips() {
+    const std::string fnname = "configure_uper_skips()";
+    const std::string prefix = "acm.uper.skip.";
+
+    for ( const auto& entry : pconf ) {
+        if ( entry.first.compare( 0, prefix.size(), prefix ) != 0 ) continue;
+
+        const std::string type_name = entry.first.substr( prefix.size() );
+        const asn_TYPE_descriptor_t* td = asn1_types.find( type_name );
+        if ( !td ) {
+            logger->error(fnname + ": " + entry.first + " names an unknown ASN.1 type.");
+            return false;
+        }
+
+        for ( std::string path : string_utilities::split( entry.second, ',' ) ) {
+            string_utilities::strip( path );
+            std::string error;
+            if ( !uper_skip::skip_member( td, path, error ) ) {
+                logger->error(fnname + ": cannot skip " + path + " in " + entry.first + ": " + error);
+                return false;
+            }
+        }
+
+        logger->info(fnname + ": the UPER decoder skips " + entry.second + " in " + type_name);
+    }
+
+    return true;
+}
+
+/**
+ * Read the columnar BSM batch settings. Batches are collected when acm.bsm.batch.directory or acm.bsm.batch.topic (or
+ * both) is set; acm.bsm.batch.rows and acm.bsm.batch.ms say when a batch is complete.
+ */
+bool ASN1_Codec::configure_bsm_batches() {
+    const std::string fnname = "configure_bsm_batches()";
+
+    auto search = pconf.find("acm.bsm.batch.directory");
+    if ( search != pconf.end() ) bsm_batch_directory = search->second;
+
+    search = pconf.find("acm.bsm.batch.topic");
+    if ( search != pconf.end() ) bsm_batch_topic = search->second;
+
+    bsm_batches = !bsm_batch_directory.empty() || !bsm_batch_topic.empty();
+    if ( !bsm_batches ) return true;
+
+    search = pconf.find("acm.bsm.batch.rows");
+    if ( search != pconf.end() ) {
+        try {
+            bsm_batch_rows = static_cast<std::size_t>( std::max( 1LL, std::stoll( search->second ) ) );
+        } catch( std::exception& e ) {
+            logger->info(fnname + ": using the default BSM batch rows.");
+        }
+    }
+
+    search = pconf.find("acm.bsm.batch.ms");
+    if ( search != pconf.end() ) {
+        try {
+            bsm_batch_age = std::chrono::milliseconds( std::max( 1LL, std::stoll( search->second ) ) );
+        } catch( std::exception& e ) {
+            logger->info(fnname + ": using the default BSM batch age.");
+        }
+    }
+
+    if ( !bsm_batch_directory.empty() ) {
+        if ( !dirExists( bsm_batch_directory ) ) {
+            logger->error(fnname + ": acm.bsm.batch.directory is not a directory: " + bsm_batch_directory);
+            return false;
+        }
+    }
+
+    logger->info(fnname + ": BSM core data batches of " + std::to_string(bsm_batch_rows) + " rows or " + std::to_string(bsm_batch_age.count()) + " ms go to "
+            + ( bsm_batch_directory.empty() ? "" : "directory " + bsm_batch_directory + " " ) + ( bsm_batch_topic.empty() ? "" : "topic " + bsm_batch_topic ));
+    return true;
+}
+
+/**
+ * Read acm.threads.cpus and acm.threads.numa. The cpus are the listed ones, the node's, or those of the listed ones
+ * that are on the node; the librdkafka clients created from conf are pinned to them.
+ */
+bool ASN1_Codec::configure_affinity() {
+    const std::string fnname = "configure_affinity()";
+    affinity::CpuList node_cpus;
+
+    auto search = pconf.find("acm.threads.cpus");
+    if ( search != pconf.end() && !affinity::parse_cpu_list( search->second, thread_cpus ) ) {
+        logger->error(fnname + ": malformed acm.threads.cpus: " + search->second);
+        return false;
+    }
+
+    search = pconf.find("acm.threads.numa");
+    if ( search != pconf.end() ) {
+        try {
+            numa_node = std::stoi( search->second );
+        } catch( std::exception& e ) {
+            logger->error(fnname + ": malformed acm.threads.numa: " + search->second);
+            return false;
+        }
+
+        if ( !affinity::numa_node_cpus( numa_node, node_cpus ) ) {
+            logger->error(fnname + ": cannot find the cpus of NUMA node " + std::to_string(numa_node));
+            return false;
+        }
+
+        thread_cpus = thread_cpus.empty() ? node_cpus : affinity::intersect( thread_cpus, node_cpus );
+        if ( thread_cpus.empty() ) {
+            logger->error(fnname + ": none of acm.threads.cpus are on NUMA node " + std::to_string(numa_node));
+            return false;
+        }
+    }
+
+    if ( thread_cpus.empty() ) return true;
+
+    rd_kafka_resp_err_t err = add_affinity_interceptors( conf->c_ptr_global(), &thread_cpus );
+    if ( err != RD_KAFKA_RESP_ERR_NO_ERROR ) {
+        logger->error(fnname + ": cannot pin the kafka client threads: " + rd_kafka_err2str(err));
+        return false;
+    }
+
+    std::string cpus;
+    for ( int cpu : thread_cpus ) {
+        cpus += ( cpus.empty() ? "" : "," ) + std::to_string( cpu );
+    }
+    logger->info(fnname + ": threads pinned to cpus " + cpus + ( numa_node < 0 ? "" : " on NUMA node " + std::to_string(numa_node) ));
+    return true;
+}
+
+void ASN1_Codec::pin_thread( const std::string& name, const affinity::CpuList& cpus ) {
+    if ( !affinity::pin_current_thread( cpus ) ) {
+        logger->warn("cannot pin the " + name + " thread; it runs on any cpu.");
+    }
+}
+
+void ASN1_Codec::init_codec_context( CodecContext& ctx ) const {
+    // every context gets its own copy of the error template since add_error_xml modifies it.
+    ctx.error_doc.reset( error_doc );
+
+    if ( arena_block_size > 0 && !ctx.arena ) {
+        ctx.arena = asn_arena_create( arena_block_size );
+    }
+}
+
+/**
+ * Decode or encode a single consumed message with the given context and turn any failure into the error XML response.
+ * This is called from the consumer thread when there is one codec worker and from the worker threads otherwise; it
+ * only touches shared state that is safe to use concurrently.
+ *
+ * @return the serialized output; empty for timeouts, eof, and consumer errors.
+ */
+OutputBuffer ASN1_Codec::codec_message( CodecContext& ctx, RdKafka::Message* msg ) {
+    const std::string fnname = "codec_message()";
+
+    // the output is serialized straight into the buffer that is handed to librdkafka; see produce_output().
+    OutputBuffer output;
+    if ( msg->err() == RdKafka::ERR_NO_ERROR ) output.reserve( ctx.output_size_hint );
+
+    try {
+
+        process_message( ctx, msg, output );          // throws.
+
+    } catch (const UnparseableInputError& e) {
+
+        logger->error(fnname + ": UnparseableInputError " + e.what() );
+        add_error_xml( ctx.error_doc, e.data_type(), e.error_type(), e.what(), true );
+        output.clear();
+        write_document( ctx, ctx.error_doc, output );
+
+    } catch (const MissingInputElementError& e) {
+
+        logger->error(fnname + ": MissingInputElementError " + e.what() );
+        add_error_xml( ctx.error_doc, e.data_type(), e.error_type(), e.what(), true );
+        output.clear();
+        write_document( ctx, ctx.error_doc, output );
+
+    } catch (const pugi::xpath_exception& e ) {
+
+        logger->error(fnname + ": pugi::xpath_exception " + e.what() );
+        add_error_xml( ctx.error_doc, Asn1DataType::ODE, Asn1ErrorType::REQUEST, e.what(), true );
+        output.clear();
+        write_document( ctx, ctx.error_doc, output );
+
+    } catch (const Asn1CodecError& e) {
+
+        logger->error(fnname + ": Asn1CodecError " + e.what());
+        add_error_xml( ctx.input_doc, e.data_type(), e.error_type(), e.what(), false );
+        output.clear();
+        write_document( ctx, ctx.input_doc, output );
+
+    }
+
+    if ( msg->err() == RdKafka::ERR_NO_ERROR ) {
+
+        logger->trace(fnname + ": " + std::to_string(msg->len()) + " bytes consumed from topic: " + msg->topic_name() );
+
+        if ( !output.empty() ) ctx.output_size_hint = output.size() + output.size() / 4;
+    } 
+
+    return output;
+}
+
+/**
+ * Fill the batch with up to batch_size consumed messages. The first message is waited for as long as the consumer
+ * timeout; after that the batch closes when it is full or when batch_linger_us has passed, but messages librdkafka has
+ * already fetched are always drained. A timeout, partition eof, or error ends the batch and is included in it, so it is
+ * handled after the messages that preceded it.
+ */
+void ASN1_Codec::consume_batch( std::vector<std::unique_ptr<RdKafka::Message>>& batch ) {
+    batch.emplace_back( consumer_ptr->consume( consumer_timeout ) );
+
+    // a rebalance inside the first consume() happened before its message; only later ones split the batch.
+    rebalanced = false;
+    if ( batch.back()->err() != RdKafka::ERR_NO_ERROR ) return;
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds( batch_linger_us );
+
+    while ( batch.size() < batch_size ) {
+        int64_t remaining_ms = std::chrono::duration_cast<std::chrono::milliseconds>( deadline - std::chrono::steady_clock::now() ).count();
+        std::unique_ptr<RdKafka::Message> msg{ consumer_ptr->consume( static_cast<int>( std::max<int64_t>( 0, remaining_ms ) ) ) };
+
+        if ( rebalanced ) {
+            drop_revoked_messages( batch );
+            rebalanced = false;
+        }
+
+        if ( msg->err() == RdKafka::ERR__TIMED_OUT ) break;
+
+        bool is_message = ( msg->err() == RdKafka::ERR_NO_ERROR );
+        batch.push_back( std::move( msg ) );
+        if ( !is_message ) break;
+    }
+}
+
+/**
+ * Remove the messages of partitions revoked while the batch was being filled. They were never tracked, and the new
+ * owner of the partition consumes them again from the committed offset.
+ */
+void ASN1_Codec::drop_revoked_messages( std::vector<std::unique_ptr<RdKafka::Message>>& batch ) {
+    std::size_t before = batch.size();
+
+    batch.erase( std::remove_if( batch.begin(), batch.end(), [this]( const std::unique_ptr<RdKafka::Message>& msg ) {
+        return msg->err() == RdKafka::ERR_NO_ERROR && revoked_partitions.count( PartitionKey{ msg->topic_name(), msg->partition() } ) > 0;
+    }), batch.end() );
+
+    if ( batch.size() != before ) {
+        logger->info("dropped " + std::to_string(before - batch.size()) + " consumed messages of revoked partitions.");
+    }
+}
+
+/**
+ * Register the offsets of a batch with their partition trackers. With a staged pipeline the trackers belong to the
+ * egress stage, so the offsets are sent there through a ring; otherwise they are tracked here.
+ */
+void ASN1_Codec::track_messages( const std::vector<std::unique_ptr<RdKafka::Message>>& batch ) {
+    Backoff backoff;
+
+    for ( auto& msg : batch ) {
+        if ( msg->err() != RdKafka::ERR_NO_ERROR ) continue;
+
+        ++msg_tracked_count;
+
+        if ( !consumed_offsets ) {
+            track_message( msg->topic_name(), msg->partition(), msg->offset() );
+            continue;
+        }
+
+        ConsumedOffset consumed{ msg->topic_name(), msg->partition(), msg->offset() };
+        while ( !consumed_offsets->try_push( std::move( consumed ) ) ) {
+            backoff.pause();
+        }
+        backoff.reset();
+    }
+}
+
+void ASN1_Codec::track_message( const std::string& topic, int32_t partition, int64_t offset ) {
+    PartitionKey key{ topic, partition };
+    auto it = partition_trackers.find( key );
+    if ( it == partition_trackers.end() ) {
+        it = partition_trackers.emplace( key, PartitionTracker<OutputBuffer>{ output_ordered } ).first;
+    }
+
+    it->second.track( offset );
+
+    // a partition whose backlog keeps growing (e.g., behind one slow message) stops fetching so the others keep flowing.
+    if ( partition_max_in_flight > 0 && it->second.in_flight() >= partition_max_in_flight ) {
+        pause_partition( key, true );
+    }
+}
+
+/**
+ * Pause a partition for its own backlog, or lift that pause. A partition whose backlog clears while consumption is
+ * paused for producer backpressure resumes with the others; see PartitionPauses.
+ */
+void ASN1_Codec::pause_partition( const PartitionKey& key, bool pause ) {
+    auto apply = [this]( const std::vector<PartitionKey>& keys, bool p ) { return set_paused( keys, p ); };
+
+    if ( pause && partition_pauses.pause( key, apply ) ) {
+        logger->info("partition " + key.first + "/" + std::to_string(key.second) + " paused with " + std::to_string(partition_max_in_flight) + " messages in flight.");
+    } else if ( !pause && partition_pauses.resume( key, apply ) ) {
+        logger->info("partition " + key.first + "/" + std::to_string(key.second) + " resumed.");
+    }
+}
+
+/**
+ * Pause or resume the partitions at the consumer; only partition_pauses calls this, with its lock held.
+ */
+bool ASN1_Codec::set_paused( const std::vector<PartitionKey>& keys, bool pause ) {
+    if ( keys.empty() ) return true;
+
+    std::vector<RdKafka::TopicPartition*> partitions;
+    for ( const auto& key : keys ) {
+        partitions.push_back( RdKafka::TopicPartition::create( key.first, key.second ) );
+    }
+
+    RdKafka::ErrorCode status = pause ? consumer_ptr->pause( partitions ) : consumer_ptr->resume( partitions );
+    if ( status != RdKafka::ERR_NO_ERROR ) {
+        logger->warn("cannot " + std::string( pause ? "pause" : "resume" ) + " " + std::to_string(keys.size()) + " partitions: " + RdKafka::err2str(status));
+    }
+
+    RdKafka::TopicPartition::destroy( partitions );
+    return status == RdKafka::ERR_NO_ERROR;
+}
+
+/**
+ * Hand a finished message to its partition tracker, publish every output that is now allowed out, and store the
+ * partition's new contiguous offset for the next commit once those outputs have been queued with the producer. Only
+ * one thread (egress, or the consumer thread with one worker) completes messages, so released outputs reach
+ * librdkafka in order.
+ */
+void ASN1_Codec::complete_message( RdKafka::Message* msg, OutputBuffer&& output ) {
+    const std::string fnname = "complete_message()";
+    std::vector<OutputBuffer> ready;
+
+    // counted however this returns, and last; drain_in_flight() relies on everything below being done.
+    struct Completion {
+        std::atomic<uint64_t>& count;
+        ~Completion() { count++; }
+    } completion{ msg_completed_count };
+
+    // every output released by a partition's tracker belongs to the pipeline of that partition's topic.
+    RdKafka::Topic* topic = pipeline_for( msg ).producer_topic_ptr.get();
+
+    PartitionKey key{ msg->topic_name(), msg->partition() };
+    auto it = partition_trackers.find( key );
+    if ( it == partition_trackers.end() ) {
+        logger->error(fnname + ": message at offset " + std::to_string(msg->offset()) + " was not tracked; publishing it unordered.");
+        produce_output( output, topic );
+        return;
+    }
+
+    bool advanced = it->second.complete( msg->offset(), std::move( output ), ready );
+
+    for ( auto& r : ready ) {
+        if ( !r.empty() ) produce_output( r, topic );
+    }
+
+    // a commit must not pass an output that is still held, so the offset waits behind them.
+    if ( advanced && held_outputs.empty() ) {
+        store_offset( key, it->second.committable() );
+    } else if ( advanced ) {
+        held_outputs.push_back( HeldOutput{ OutputBuffer{}, nullptr, key, it->second.committable() } );
+    }
+
+    if ( partition_max_in_flight > 0 && it->second.in_flight() <= partition_max_in_flight / 2 ) {
+        pause_partition( key, false );
+    }
+}
+
+/**
+ * Queue one output with the producer. The buffer is passed with RK_MSG_FREE, so librdkafka takes ownership and frees
+ * it after delivery instead of copying it. When librdkafka's local queue is full the output is held, behind any that
+ * are already held, and produce_backpressure tells the consumer thread to pause its partitions until
+ * produce_held_outputs has queued them all. Nothing here waits, so the consumer thread keeps polling.
+ */
+void ASN1_Codec::produce_output( OutputBuffer& output, RdKafka::Topic* topic ) {
+    const std::string fnname = "produce_output()";
+
+    if ( held_outputs.empty() && produce_now( output, topic ) ) return;
+
+    if ( !produce_backpressure.exchange( true ) ) {
+        logger->warn(fnname + ": producer queue is full; pausing consumption until deliveries catch up.");
+    }
+
+    held_outputs.push_back( HeldOutput{ std::move( output ), topic, PartitionKey{}, -1 } );
+}
+
+/**
+ * Queue the held outputs in order, as far as librdkafka has room, and store each offset that was waiting for them;
+ * called by the thread that completes messages.
+ *
+ * @return true if no output is held any more.
+ */
+bool ASN1_Codec::produce_held_outputs() {
+    const std::string fnname = "produce_held_outputs()";
+
+    while ( !held_outputs.empty() ) {
+        HeldOutput& held = held_outputs.front();
+        if ( held.topic && !produce_now( held.output, held.topic ) ) return false;
+        if ( held.offset >= 0 ) store_offset( held.key, held.offset );
+        held_outputs.pop_front();
+    }
+
+    if ( produce_backpressure.exchange( false ) ) {
+        logger->info(fnname + ": producer caught up; resuming consumption.");
+    }
+    return true;
+}
+
+/**
+ * Hand one output to librdkafka.
+ *
+ * @return false if its local queue is full and the output must be held. Any other failure is logged and counted, and
+ * the output dropped.
+ */
+bool ASN1_Codec::produce_now( OutputBuffer& output, RdKafka::Topic* topic ) {
+    const std::string fnname = "produce_now()";
+
+    RdKafka::ErrorCode status = producer_ptr->produce(topic, partition, RdKafka::Producer::RK_MSG_FREE, output.data(), output.size(), NULL, NULL);
+
+    if ( status == RdKafka::ERR__QUEUE_FULL ) return false;
+
+    if (status != RdKafka::ERR_NO_ERROR) {
+        logger->error(fnname + ": cannot queue " + std::to_string(output.size()) + " bytes for topic " + topic->name() + ": " + RdKafka::err2str(status));
+        msg_fail_count++;
+        return true;
+    }
+
+    // the published counters are updated by the delivery report.
+    logger->trace(fnname + ": successful encoding/decoding");
+    logger->trace(fnname + ": " + std::to_string(output.size()) + " bytes queued for topic: " + topic->name());
+
+    // librdkafka frees the memory.
+    output.release();
+    return true;
+}
+
+/**
+ * Store the offset the partition's next commit starts from.
+ */
+void ASN1_Codec::store_offset( const PartitionKey& key, int64_t offset ) {
+    const std::string fnname = "store_offset()";
+
+    std::vector<RdKafka::TopicPartition*> offsets{ RdKafka::TopicPartition::create( key.first, key.second, offset ) };
+    RdKafka::ErrorCode status = consumer_ptr->offsets_store( offsets );
+    if ( status != RdKafka::ERR_NO_ERROR ) {
+        logger->warn(fnname + ": cannot store offset " + std::to_string(offset) + " for partition " + key.first + "/" + std::to_string(key.second) + ": " + RdKafka::err2str(status));
+    }
+    RdKafka::TopicPartition::destroy( offsets );
+}
+
+/**
+ * Queue whatever is still held at the end of a session while the delivery poller makes room. Outputs still held
+ * after a few seconds are dropped and counted as failures; the offsets behind them are not stored, so they are
+ * consumed again by the next session.
+ */
+void ASN1_Codec::drain_held_outputs() {
+    const std::string fnname = "drain_held_outputs()";
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds( 5000 );
+
+    while ( !produce_held_outputs() ) {
+        if ( std::chrono::steady_clock::now() >= deadline ) {
+            std::size_t dropped = 0;
+            for ( const auto& held : held_outputs ) {
+                if ( held.topic ) ++dropped;
+            }
+
+            logger->error(fnname + ": dropping " + std::to_string(dropped) + " outputs the producer had no room for.");
+            msg_fail_count += dropped;
+            held_outputs.clear();
+            produce_backpressure = false;
+            return;
+        }
+
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    }
+}
+
+void ASN1_Codec::DeliveryReporter::dr_cb( RdKafka::Message& message ) {
+    // BSM batches are not counted with the outputs.
+    if ( message.msg_opaque() == static_cast<void*>( &codec_.bsm_batch_count ) ) {
+        if ( message.err() != RdKafka::ERR_NO_ERROR ) {
+            codec_.logger->error("delivery of a BSM batch to topic " + message.topic_name() + " failed: " + message.errstr());
+        }
+        return;
+    }
+
+    if ( message.err() != RdKafka::ERR_NO_ERROR ) {
+        codec_.msg_fail_count++;
+        codec_.logger->error("delivery of " + std::to_string(message.len()) + " bytes to topic " + message.topic_name() + " failed: " + message.errstr());
+        return;
+    }
+
+    codec_.msg_send_count++;
+    codec_.msg_send_bytes += message.len();
+}
+
+void ASN1_Codec::start_delivery_poller() {
+    if ( delivery_polling.exchange( true ) ) return;
+
+    delivery_poller = std::thread( [this]() {
+        pin_thread( "delivery poller", thread_cpus );
+
+        while ( delivery_polling ) {
+            producer_ptr->poll( 100 );
+        }
+    });
+}
+
+void ASN1_Codec::stop_delivery_poller() {
+    if ( !delivery_polling.exchange( false ) ) return;
+
+    delivery_poller.join();
+
+    // serve the remaining delivery reports so the counters are final.
+    if ( producer_ptr && producer_ptr->flush( 5000 ) != RdKafka::ERR_NO_ERROR ) {
+        logger->warn("ASN1_Codec: " + std::to_string(producer_ptr->outq_len()) + " outputs were not delivered before shutdown.");
+    }
+}
+
+/**
+ * Pause or resume every partition assigned to the consumer; partitions still paused for their own backlog are not
+ * resumed. The consumer keeps calling consume() while paused, which keeps it in the group without fetching more data.
+ */
+void ASN1_Codec::pause_consumption( bool pause ) {
+    std::vector<RdKafka::TopicPartition*> partitions;
+
+    RdKafka::ErrorCode status = consumer_ptr->assignment( partitions );
+    if ( status != RdKafka::ERR_NO_ERROR ) {
+        logger->error("cannot " + std::string( pause ? "pause" : "resume" ) + " consumption: " + RdKafka::err2str(status));
+        return;
+    }
+
+    std::vector<PartitionKey> assigned;
+    for ( auto tp : partitions ) {
+        assigned.emplace_back( tp->topic(), tp->partition() );
+    }
+    RdKafka::TopicPartition::destroy( partitions );
+
+    int count = partition_pauses.set_all( std::move( assigned ), pause,
+            [this]( const std::vector<PartitionKey>& keys, bool p ) { return set_paused( keys, p ); } );
+
+    if ( count < 0 ) {
+        logger->error("cannot " + std::string( pause ? "pause" : "resume" ) + " consumption.");
+    } else {
+        logger->info("consumption " + std::string( pause ? "paused" : "resumed" ) + " for " + std::to_string(count) + " partitions.");
+    }
+}
+
+void ASN1_Codec::Rebalancer::rebalance_cb( RdKafka::KafkaConsumer* consumer, RdKafka::ErrorCode err, std::vector<RdKafka::TopicPartition*>& partitions ) {
+    bool incremental = ( consumer->rebalance_protocol() == "COOPERATIVE" );
+
+    if ( err == RdKafka::ERR__ASSIGN_PARTITIONS ) {
+        codec_.partitions_assigned( partitions, incremental );
+    } else {
+        // ERR__REVOKE_PARTITIONS, or an error that loses the assignment.
+        if ( err != RdKafka::ERR__REVOKE_PARTITIONS ) {
+            codec_.logger->error("rebalance failed: " + RdKafka::err2str(err));
+        }
+        codec_.partitions_revoked( partitions, incremental );
+    }
+}
+
+/**
+ * Take the new partitions. With the cooperative protocol they are added to the current assignment and the partitions
+ * that were kept never stop; with the eager protocol they replace it. If the consumer is paused for producer
+ * backpressure the new partitions start paused too.
+ */
+void ASN1_Codec::partitions_assigned( std::vector<RdKafka::TopicPartition*>& partitions, bool incremental ) {
+    RdKafka::ErrorCode status = RdKafka::ERR_NO_ERROR;
+
+    if ( incremental ) {
+        RdKafka::Error* error = consumer_ptr->incremental_assign( partitions );
+        if ( error ) {
+            status = error->code();
+            delete error;
+        }
+    } else {
+        status = consumer_ptr->assign( partitions );
+    }
+
+    if ( status != RdKafka::ERR_NO_ERROR ) {
+        logger->error("cannot assign " + std::to_string(partitions.size()) + " partitions: " + RdKafka::err2str(status));
+        return;
+    }
+
+    if ( partition_pauses.all_paused() ) consumer_ptr->pause( partitions );
+
+    logger->info("assigned " + std::to_string(partitions.size()) + " partitions (" + std::string( incremental ? "cooperative" : "eager" ) + ").");
+}
+
+/**
+ * Give up partitions. Every message already handed to the codec is finished and published first and the stored
+ * offsets are committed, so the next owner starts exactly where this instance stopped; then the trackers of the
+ * revoked partitions are dropped. With the cooperative protocol only the listed partitions are given up.
+ */
+void ASN1_Codec::partitions_revoked( std::vector<RdKafka::TopicPartition*>& partitions, bool incremental ) {
+    drain_in_flight();
+
+    RdKafka::ErrorCode status = consumer_ptr->commitSync();
+    if ( status != RdKafka::ERR_NO_ERROR ) {
+        // ERR__NO_OFFSET simply means nothing new was stored.
+        logger->info("commit before revoking partitions: " + RdKafka::err2str(status));
+    }
+
+    revoked_partitions.clear();
+    for ( auto tp : partitions ) {
+        PartitionKey key{ tp->topic(), tp->partition() };
+        revoked_partitions.insert( key );
+
+        // the pipeline is idle, so the trackers can be touched from this thread.
+        partition_trackers.erase( key );
+        partition_pauses.erase( key );
+    }
+
+    if ( incremental ) {
+        RdKafka::Error* error = consumer_ptr->incremental_unassign( partitions );
+        if ( error ) {
+            status = error->code();
+            delete error;
+        }
+    } else {
+        partition_trackers.clear();
+        partition_pauses.clear_partitions();
+        status = consumer_ptr->unassign();
+    }
+
+    if ( status != RdKafka::ERR_NO_ERROR ) {
+        logger->error("cannot unassign " + std::to_string(partitions.size()) + " partitions: " + RdKafka::err2str(status));
+    }
+
+    rebalanced = true;
+    logger->info("revoked " + std::to_string(partitions.size()) + " partitions (" + std::string( incremental ? "cooperative" : "eager" ) + ").");
+}
+
+/**
+ * Wait until every tracked message has completed and its output has been queued with the producer. The wait is
+ * bounded by the pipeline's capacity: nothing new is dispatched while the consumer thread is here.
+ */
+void ASN1_Codec::drain_in_flight() {
+    Backoff backoff;
+
+    while ( msg_completed_count.load() < msg_tracked_count || produce_backpressure ) {
+        // with one worker the held outputs belong to this thread.
+        if ( !consumed_offsets && !held_outputs.empty() ) produce_held_outputs();
+        backoff.pause();
+    }
+}
+
+void ASN1_Codec::codec_worker( std::size_t index ) {
+    // each worker gets its own cpu; pinning before the context is built places its memory on that cpu's node.
+    if ( !thread_cpus.empty() ) {
+        pin_thread( "codec worker " + std::to_string(index), affinity::CpuList{ thread_cpus[ index % thread_cpus.size() ] } );
+    }
+
+    // the context is built on the worker thread; it is never shared.
+    CodecContext ctx{};
+    SpscRing<CodecResult>& output = *codec_outputs[index];
+    std::unique_ptr<RdKafka::Message> msg;
+    Backoff backoff;
+
+    init_codec_context( ctx );
+
+    while ( true ) {
+        // ingest_done is read before looking at the queues so nothing dispatched before it is missed.
+        bool draining = ingest_done;
+
+        if ( !take_work( index, msg ) ) {
+            if ( draining ) break;
+            // an idle worker still writes its BSM batch on time.
+            if ( bsm_batches ) flush_bsm_batch( ctx, false );
+            backoff.pause();
+            continue;
+        }
+        backoff.reset();
+
+        CodecResult result{ std::move( msg ), OutputBuffer{} };
+        result.output = codec_message( ctx, result.message.get() );
+
+        while ( !output.try_push( std::move( result ) ) ) {
+            backoff.pause();
+        }
+        backoff.reset();
+    }
+
+    if ( bsm_batches ) flush_bsm_batch( ctx, true );
+    workers_done++;
+}
+
+/**
+ * Take the next message for worker index: the oldest in its own run queue or, when that is empty, the oldest in the
+ * first other worker's queue that has any. Stealing keeps every worker busy when a few expensive messages (e.g., an
+ * ASD wrapping a signed TIM) hold up the worker they were dispatched to; partition order is restored by the trackers.
+ */
+bool ASN1_Codec::take_work( std::size_t index, std::unique_ptr<RdKafka::Message>& msg ) {
+    if ( codec_inputs[index]->try_pop( msg ) ) return true;
+
+    for ( std::size_t i = 1; i < codec_threads; ++i ) {
+        if ( codec_inputs[ ( index + i ) % codec_threads ]->try_pop( msg ) ) {
+            msg_steal_count++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * The egress stage: track consumed offsets, release finished results in partition order, produce them, and store
+ * the committable offsets. It exits once every worker has exited and their rings are drained.
+ */
+void ASN1_Codec::egress_worker() {
+    pin_thread( "egress", thread_cpus );
+
+    ConsumedOffset consumed;
+    CodecResult result;
+    Backoff backoff;
+
+    while ( true ) {
+        // read before draining so the last results of exiting workers are always seen.
+        bool finished = ( workers_done == codec_threads );
+        bool progress = false;
+
+        // outputs held for a full producer queue go first; results keep being completed behind them.
+        if ( !held_outputs.empty() ) produce_held_outputs();
+
+        for ( auto& ring : codec_outputs ) {
+            while ( ring->try_pop( result ) ) {
+                // a result's offset was sent before the message was dispatched, so it is in the ring by now.
+                while ( consumed_offsets->try_pop( consumed ) ) {
+                    track_message( consumed.topic, consumed.partition, consumed.offset );
+                }
+
+                complete_message( result.message.get(), std::move( result.output ) );
+                result.message.reset();
+                progress = true;
+            }
+        }
+
+        // keep the offset ring moving while the workers are busy.
+        while ( consumed_offsets->try_pop( consumed ) ) {
+            track_message( consumed.topic, consumed.partition, consumed.offset );
+            progress = true;
+        }
+
+        if ( progress ) {
+            backoff.reset();
+        } else if ( finished ) {
+            break;
+        } else {
+            backoff.pause();
+        }
+    }
+}
+
+void ASN1_Codec::start_codec_workers() {
+    if ( codec_threads <= 1 ) return;
+
+    ingest_done = false;
+    workers_done = 0;
+    next_worker = 0;
+
+    // the offset ring holds every message that can be in flight, so ingest rarely waits on it.
+    consumed_offsets = std::unique_ptr<SpscRing<ConsumedOffset>>( new SpscRing<ConsumedOffset>{ 2 * codec_threads * codec_queue_size + batch_size } );
+
+    for ( std::size_t i = 0; i < codec_threads; ++i ) {
+        codec_inputs.emplace_back( new StealingQueue<std::unique_ptr<RdKafka::Message>>{ codec_queue_size } );
+        codec_outputs.emplace_back( new SpscRing<CodecResult>{ codec_queue_size } );
+    }
+
+    for ( std::size_t i = 0; i < codec_threads; ++i ) {
+        codec_workers.emplace_back( &ASN1_Codec::codec_worker, this, i );
+    }
+
+    egress = std::thread( &ASN1_Codec::egress_worker, this );
+
+    logger->info("Started " + std::to_string(codec_threads) + " codec workers and an egress stage with rings of " + std::to_string(codec_inputs.front()->capacity()) + " messages.");
+}
+
+void ASN1_Codec::stop_codec_workers() {
+    if ( !consumed_offsets ) return;
+
+    // workers finish what has already been consumed, and egress publishes it, before they exit.
+    ingest_done = true;
+    for ( auto& worker : codec_workers ) {
+        worker.join();
+    }
+    egress.join();
+
+    logger->info("Codec workers stole " + std::to_string(msg_steal_count) + " messages from busier workers.");
+
+    codec_workers.clear();
+    codec_inputs.clear();
+    codec_outputs.clear();
+    consumed_offsets.reset();
+}
+
+/**
+ * Hand a consumed message to the next codec worker whose run queue has room. When every queue is full the consumer
+ * waits, so the number of messages held in the pipeline is bounded.
+ */
+void ASN1_Codec::dispatch_message( std::unique_ptr<RdKafka::Message>&& msg ) {
+    Backoff backoff;
+
+    while ( true ) {
+        for ( std::size_t i = 0; i < codec_threads; ++i ) {
+            std::size_t w = next_worker;
+            next_worker = ( next_worker + 1 ) % codec_threads;
+
+            if ( codec_inputs[w]->try_push( std::move( msg ) ) ) return;
+        }
+
+        backoff.pause();
+    }
+}
+
 int ASN1_Codec::operator()(void) {
     const std::string fnname = "run()";
 
-    RdKafka::ErrorCode status;
-    std::string error_string;
-    bool success = false;
-
-    std::stringstream output_msg_stream;
+    std::vector<std::unique_ptr<RdKafka::Message>> batch;
 
     signal(SIGINT, sigterm);
     signal(SIGTERM, sigterm);
@@ -1791,6 +3403,9 @@ int ASN1_Codec::operator()(void) {
         return EXIT_FAILURE;
     }
 
+    // the consumer (ingest) thread; main_context is first touched below, so it too is allocated on the node.
+    pin_thread( "consumer", thread_cpus );
+
     while (bootstrap) {
         // reset flag here, or else nothing works below
         data_available = true;
@@ -1807,72 +3422,66 @@ int ASN1_Codec::operator()(void) {
             continue;
         }
 
+        start_delivery_poller();
+        start_codec_workers();
+
         // consume-produce loop.
         while (data_available) {
 
-            std::unique_ptr<RdKafka::Message> msg{ consumer_ptr->consume( consumer_timeout ) };
-
-            try {
-
-                success = process_message( msg.get(), output_msg_stream );          // throws.
-
-            } catch (const UnparseableInputError& e) {
-
-                logger->error(fnname + ": UnparseableInputError " + e.what() );
-                add_error_xml( error_doc, e.data_type(), e.error_type(), e.what(), true );
-                error_doc.save(output_msg_stream,"",pugi::format_raw);
+            // with one worker the consumer thread produces, so it also retries the held outputs.
+            if ( !consumed_offsets && !held_outputs.empty() ) produce_held_outputs();
 
-            } catch (const MissingInputElementError& e) {
-
-                logger->error(fnname + ": MissingInputElementError " + e.what() );
-                add_error_xml( error_doc, e.data_type(), e.error_type(), e.what(), true );
-                error_doc.save(output_msg_stream,"",pugi::format_raw);
-
-            } catch (const pugi::xpath_exception& e ) {
-
-                logger->error(fnname + ": pugi::xpath_exception " + e.what() );
-                add_error_xml( error_doc, Asn1DataType::ODE, Asn1ErrorType::REQUEST, e.what(), true );
-                error_doc.save(output_msg_stream,"",pugi::format_raw);
+            if ( produce_backpressure != partition_pauses.all_paused() ) {
+                pause_consumption( produce_backpressure );
+            }
 
-            } catch (const Asn1CodecError& e) {
+            consume_batch( batch );
+            track_messages( batch );
 
-                logger->error(fnname + ": Asn1CodecError " + e.what());
-                add_error_xml( input_doc, e.data_type(), e.error_type(), e.what(), false );
-                input_doc.save(output_msg_stream,"",pugi::format_raw);
+            for ( auto& msg : batch ) {
+                if ( consumed_offsets && msg->err() == RdKafka::ERR_NO_ERROR ) {
+                    // waits when every worker is busy and its ring is full.
+                    dispatch_message( std::move( msg ) );
+                    continue;
+                }
 
+                // timeouts, eof, and errors are always handled here; with one worker so are the messages.
+                OutputBuffer output = codec_message( main_context, msg.get() );
+                if ( msg->err() == RdKafka::ERR_NO_ERROR ) {
+                    complete_message( msg.get(), std::move( output ) );
+                }
             }
 
-            if ( msg->len() > 0 ) {
+            batch.clear();
 
-                logger->trace(fnname + ": " + std::to_string(msg->len()) + " bytes consumed from topic: " + consumed_topics[0] );
+            if ( bsm_batches ) flush_bsm_batch( main_context, false );
 
-                std::string output_msg_string = output_msg_stream.str();
-                status = producer_ptr->produce(published_topic_ptr.get(), partition, RdKafka::Producer::RK_MSG_COPY, (void *)output_msg_string.c_str(), output_msg_string.size(), NULL, NULL);
-
-                if (status != RdKafka::ERR_NO_ERROR) {
-                    logger->error(fnname + ": Failure of XER encoding: " + RdKafka::err2str(status));
+            // NOTE: good for troubleshooting, but bad for performance; once per batch amortizes it.
+            logger->flush();
+        }
 
-                } else {
-                    // successfully sent; update counters.
-                    msg_send_count++;
-                    msg_send_bytes += output_msg_string.size();
-                    logger->trace(fnname + ": successful encoding/decoding");
-                    logger->trace(fnname + ": " + std::to_string(output_msg_string.size()) + " bytes produced to topic: " + published_topic_ptr->name());
-                }
+        stop_codec_workers();
 
-                // clear out the stream
-                output_msg_stream.str("");
-                output_msg_stream.clear();
-            } 
+        // the delivery poller is still running, so held outputs get room as deliveries complete.
+        drain_held_outputs();
+        if ( bsm_batches ) flush_bsm_batch( main_context, true );
+        stop_delivery_poller();
+        partition_trackers.clear();
 
-            // NOTE: good for troubleshooting, but bad for performance.
-            logger->flush();
-        }
+        // the next session starts with nothing paused.
+        bool resume = partition_pauses.all_paused();
+        partition_pauses.clear();
+        if ( resume ) pause_consumption( false );
     }
 
     logger->info("ASN1_Codec operations complete; shutting down...");
     logger->info("ASN1_Codec consumed  : " + std::to_string(msg_recv_count) + " blocks and " + std::to_string(msg_recv_bytes) + " bytes");
     logger->info("ASN1_Codec published : " + std::to_string(msg_send_count) + " blocks and " + std::to_string(msg_send_bytes) + " bytes");
+    logger->info("ASN1_Codec failed    : " + std::to_string(msg_fail_count) + " blocks");
+    logger->info("ASN1_Codec constraint violations: " + std::to_string(constraint_violations) + " of " + std::to_string(constraint_checks) + " checked structures");
+    if ( bsm_batches ) {
+        logger->info("ASN1_Codec BSM batches: " + std::to_string(bsm_batch_count) + " batches of " + std::to_string(bsm_batch_row_count) + " BSMs");
+    }
     return EXIT_SUCCESS;
 }
 
@@ -0,0 +1,106 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#include "affinity.hpp"
+#include "utilities.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+bool affinity::parse_cpu_list( const std::string& list, CpuList& cpus ) {
+    CpuList r;
+
+    for ( std::string range : string_utilities::split( list, ',' ) ) {
+        string_utilities::strip( range );
+        if ( range.empty() ) continue;
+
+        std::size_t dash = range.find( '-' );
+        int first, last;
+
+        try {
+            std::size_t used = 0;
+            first = std::stoi( range.substr( 0, dash ), &used );
+            if ( used != range.substr( 0, dash ).size() ) return false;
+
+            if ( dash == std::string::npos ) {
+                last = first;
+            } else {
+                last = std::stoi( range.substr( dash + 1 ), &used );
+                if ( used != range.size() - dash - 1 ) return false;
+            }
+        } catch ( std::exception& ) {
+            return false;
+        }
+
+        if ( first < 0 || last < first ) return false;
+
+        for ( int cpu = first; cpu <= last; ++cpu ) {
+            r.push_back( cpu );
+        }
+    }
+
+    if ( r.empty() ) return false;
+
+    std::sort( r.begin(), r.end() );
+    r.erase( std::unique( r.begin(), r.end() ), r.end() );
+    cpus.swap( r );
+    return true;
+}
+
+bool affinity::numa_node_cpus( int node, CpuList& cpus ) {
+    if ( node < 0 ) return false;
+
+    std::ifstream file{ "/sys/devices/system/node/node" + std::to_string( node ) + "/cpulist" };
+    std::string list;
+
+    if ( !file.good() || !std::getline( file, list ) ) return false;
+
+    return parse_cpu_list( list, cpus );
+}
+
+affinity::CpuList affinity::intersect( const CpuList& a, const CpuList& b ) {
+    CpuList r;
+    std::set_intersection( a.begin(), a.end(), b.begin(), b.end(), std::back_inserter( r ) );
+    return r;
+}
+
+bool affinity::pin_current_thread( const CpuList& cpus ) {
+    if ( cpus.empty() ) return true;
+
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO( &set );
+
+    for ( int cpu : cpus ) {
+        if ( cpu < CPU_SETSIZE ) CPU_SET( cpu, &set );
+    }
+
+    return pthread_setaffinity_np( pthread_self(), sizeof( set ), &set ) == 0;
+#else
+    return false;
+#endif
+}
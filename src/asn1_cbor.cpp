@@ -0,0 +1,314 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#include "asn1_cbor.hpp"
+#include "asn1_walk.hpp"
+
+#include "INTEGER.h"
+#include "OCTET_STRING.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// CBOR major types.
+const uint8_t cbor_unsigned = 0;
+const uint8_t cbor_negative = 1;
+const uint8_t cbor_bytes = 2;
+const uint8_t cbor_text = 3;
+const uint8_t cbor_array = 4;
+const uint8_t cbor_map = 5;
+
+const char cbor_false = static_cast<char>( 0xF4 );
+const char cbor_true = static_cast<char>( 0xF5 );
+const char cbor_null = static_cast<char>( 0xF6 );
+
+/**
+ * CBOR output that appends to a std::string.
+ */
+struct StringOut {
+    std::string& s;
+
+    void write( const char* data, std::size_t size ) {
+        s.append( data, size );
+    }
+};
+
+/**
+ * CBOR output that writes to a pugi::xml_writer (e.g., an OutputBuffer) in chunks.
+ */
+class XmlWriterOut {
+    public:
+
+        explicit XmlWriterOut( pugi::xml_writer& output ) :
+            output_( output )
+            , size_{ 0 }
+        {}
+
+        void write( const char* data, std::size_t size ) {
+            if ( size_ + size > sizeof buffer_ ) {
+                flush();
+                // e.g., a raw payload; no point in copying it.
+                if ( size >= sizeof buffer_ ) {
+                    output_.write( data, size );
+                    return;
+                }
+            }
+
+            std::memcpy( buffer_ + size_, data, size );
+            size_ += size;
+        }
+
+        void flush() {
+            if ( size_ ) output_.write( buffer_, size_ );
+            size_ = 0;
+        }
+
+    private:
+        pugi::xml_writer& output_;
+        char buffer_[ 1024 ];
+        std::size_t size_;
+};
+
+/**
+ * The initial byte of a data item and its argument in the fewest bytes that hold it.
+ */
+template<typename Out>
+void put_head( Out& out, uint8_t major, uint64_t value ) {
+    char head[ 9 ];
+    std::size_t size;
+    uint8_t type = static_cast<uint8_t>( major << 5 );
+
+    if ( value < 24 ) {
+        head[0] = static_cast<char>( type | value );
+        size = 1;
+    } else if ( value <= 0xFF ) {
+        head[0] = static_cast<char>( type | 24 );
+        size = 2;
+    } else if ( value <= 0xFFFF ) {
+        head[0] = static_cast<char>( type | 25 );
+        size = 3;
+    } else if ( value <= 0xFFFFFFFF ) {
+        head[0] = static_cast<char>( type | 26 );
+        size = 5;
+    } else {
+        head[0] = static_cast<char>( type | 27 );
+        size = 9;
+    }
+
+    for ( std::size_t i = 1; i < size; ++i ) {
+        head[i] = static_cast<char>( ( value >> ( 8 * ( size - 1 - i ) ) ) & 0xFF );
+    }
+
+    out.write( head, size );
+}
+
+template<typename Out>
+void put_int( Out& out, long long value ) {
+    if ( value >= 0 ) {
+        put_head( out, cbor_unsigned, static_cast<uint64_t>( value ) );
+    } else {
+        put_head( out, cbor_negative, static_cast<uint64_t>( -1 - value ) );
+    }
+}
+
+template<typename Out>
+void put_string( Out& out, uint8_t major, const char* data, std::size_t size ) {
+    put_head( out, major, size );
+    out.write( data, size );
+}
+
+/**
+ * The content of an element: the raw data item, a map of its child elements, or its text.
+ */
+template<typename Out>
+void write_content( Out& out, pugi::xml_node node, pugi::xml_node raw_node, const std::string& raw_cbor ) {
+    if ( node == raw_node && !raw_cbor.empty() ) {
+        out.write( raw_cbor.data(), raw_cbor.size() );
+        return;
+    }
+
+    // each name once, in order of first appearance; repeats become an array. A map's size comes first, so the names
+    // are gathered before anything is written.
+    std::vector<const char*> names;
+    asn1_walk::element_names( node, names );
+
+    if ( names.empty() ) {
+        const char* text = node.child_value();
+        put_string( out, cbor_text, text, std::strlen( text ) );
+        return;
+    }
+
+    put_head( out, cbor_map, names.size() );
+    for ( const char* name : names ) {
+        pugi::xml_node child = node.child( name );
+        put_string( out, cbor_text, name, std::strlen( name ) );
+
+        if ( !child.next_sibling( name ) ) {
+            write_content( out, child, raw_node, raw_cbor );
+            continue;
+        }
+
+        std::size_t count = 0;
+        for ( pugi::xml_node item = child; item; item = item.next_sibling( name ) ) ++count;
+
+        put_head( out, cbor_array, count );
+        for ( pugi::xml_node item = child; item; item = item.next_sibling( name ) ) {
+            write_content( out, item, raw_node, raw_cbor );
+        }
+    }
+}
+
+}  // end namespace.
+
+namespace asn1_cbor {
+
+/**
+ * Writes what asn1_walk::Walker finds behind Writer::append; it is a class so it can use the writer's scratch buffer.
+ */
+class Encoder {
+    public:
+
+        // a map or array starts with its size.
+        static constexpr bool sized = true;
+
+        Encoder( Writer& writer, std::string& out ) :
+            writer_( writer )
+            , out_{ out }
+        {}
+
+        bool start_map( std::size_t size ) {
+            put_head( out_, cbor_map, size );
+            return true;
+        }
+
+        bool end_map() {
+            return true;
+        }
+
+        bool start_array( std::size_t size ) {
+            put_head( out_, cbor_array, size );
+            return true;
+        }
+
+        bool end_array() {
+            return true;
+        }
+
+        bool key( const char* name ) {
+            put_string( out_, cbor_text, name, std::strlen( name ) );
+            return true;
+        }
+
+        bool integer( long v ) {
+            put_int( out_, v );
+            return true;
+        }
+
+        bool unsigned_integer( unsigned long v ) {
+            put_head( out_, cbor_unsigned, v );
+            return true;
+        }
+
+        bool identifier( const char* name ) {
+            put_string( out_, cbor_text, name, std::strlen( name ) );
+            return true;
+        }
+
+        bool boolean( bool v ) {
+            out_.write( v ? &cbor_true : &cbor_false, 1 );
+            return true;
+        }
+
+        bool null() {
+            out_.write( &cbor_null, 1 );
+            return true;
+        }
+
+        /**
+         * Any other leaf: a byte string for an OCTET STRING, an integer for an INTEGER that fits a long, and otherwise
+         * a text string of its text (see asn1_walk::leaf_text).
+         */
+        bool leaf( const asn_TYPE_descriptor_t* td, const void* sptr ) {
+            const asn_TYPE_operation_t* op = td->op;
+
+            if ( op == &asn_OP_OCTET_STRING ) {
+                const OCTET_STRING_t* octets = static_cast<const OCTET_STRING_t*>( sptr );
+                put_string( out_, cbor_bytes, reinterpret_cast<const char*>( octets->buf ), octets->size );
+                return true;
+            }
+
+            if ( op == &asn_OP_INTEGER ) {
+                const asn_INTEGER_specifics_t* specs = static_cast<const asn_INTEGER_specifics_t*>( td->specifics );
+                const INTEGER_t* number = static_cast<const INTEGER_t*>( sptr );
+                long v;
+                unsigned long u;
+
+                if ( specs && specs->field_unsigned && asn_INTEGER2ulong( number, &u ) == 0 ) return unsigned_integer( u );
+                if ( asn_INTEGER2long( number, &v ) == 0 ) return integer( v );
+                // too large for a long; its XER text.
+            }
+
+            asn1_walk::Leaf leaf;
+            const asn_TYPE_descriptor_t* failed = asn1_walk::leaf_text( td, sptr, writer_.scratch_, leaf );
+            if ( failed ) return fail( failed );
+
+            put_string( out_, cbor_text, leaf.data, leaf.size );
+            return true;
+        }
+
+        bool fail( const asn_TYPE_descriptor_t* td ) {
+            writer_.failed_type_ = td;
+            return false;
+        }
+
+    private:
+
+        Writer& writer_;
+        StringOut out_;
+};
+
+}  // end namespace.
+
+bool asn1_cbor::Writer::append( std::string& out, const asn_TYPE_descriptor_t* td, const void* sptr, const Projection* projection ) {
+    failed_type_ = nullptr;
+
+    Encoder encoder{ *this, out };
+    asn1_walk::Walker<Encoder> walker{ encoder };
+    encoder.start_map( 1 );
+    encoder.key( td->xml_tag );
+    return walker.value( td, sptr, projection && !projection->whole() ? projection : nullptr );
+}
+
+void asn1_cbor::write_document( const pugi::xml_document& doc, pugi::xml_writer& output, pugi::xml_node raw_node, const std::string& raw_cbor ) {
+    XmlWriterOut out{ output };
+
+    pugi::xml_node root = doc.document_element();
+    if ( root ) {
+        write_content( out, root, raw_node, raw_cbor );
+    } else {
+        put_head( out, cbor_map, 0 );
+    }
+
+    out.flush();
+}
@@ -0,0 +1,155 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#include "asn1_dom.hpp"
+#include "asn1_walk.hpp"
+
+#include "BOOLEAN.h"
+#include "INTEGER.h"
+#include "NativeEnumerated.h"
+#include "NativeInteger.h"
+#include "OPEN_TYPE.h"
+#include "asn_SEQUENCE_OF.h"
+#include "constr_CHOICE.h"
+#include "constr_SEQUENCE.h"
+#include "constr_SEQUENCE_OF.h"
+#include "constr_SET_OF.h"
+
+#include <cstdio>
+
+pugi::xml_node asn1_dom::Builder::append( pugi::xml_node parent, const asn_TYPE_descriptor_t* td, const void* sptr, const Projection* projection ) {
+    failed_type_ = nullptr;
+
+    pugi::xml_node node = parent.append_child( td->xml_tag );
+    if ( !fill( node, td, sptr, projection && !projection->whole() ? projection : nullptr ) ) {
+        parent.remove_child( node );
+        return pugi::xml_node{};
+    }
+
+    return node;
+}
+
+/**
+ * Fill node with the value; with a projection only the selected members of constructed types are built.
+ */
+bool asn1_dom::Builder::fill( pugi::xml_node node, const asn_TYPE_descriptor_t* td, const void* sptr, const Projection* projection ) {
+    const asn_TYPE_operation_t* op = td->op;
+
+    if ( op == &asn_OP_SEQUENCE ) {
+        for ( unsigned i = 0; i < td->elements_count; ++i ) {
+            if ( !fill_member( node, td->elements[i], sptr, projection ) ) return false;
+        }
+        return true;
+    }
+
+    if ( op == &asn_OP_CHOICE || op == &asn_OP_OPEN_TYPE ) {
+        // an open type is held like a CHOICE of the types its selector allows, and XER writes it the same way.
+        unsigned present = CHOICE_variant_get_presence( td, sptr );
+        if ( present == 0 || present > td->elements_count ) return fail( td );
+
+        return fill_member( node, td->elements[ present - 1 ], sptr, projection );
+    }
+
+    if ( op == &asn_OP_SEQUENCE_OF || op == &asn_OP_SET_OF ) {
+        return fill_list( node, td, sptr, projection );
+    }
+
+    if ( op == &asn_OP_NativeInteger ) {
+        const asn_INTEGER_specifics_t* specs = static_cast<const asn_INTEGER_specifics_t*>( td->specifics );
+        long value = *static_cast<const long*>( sptr );
+        char buf[ 32 ];
+
+        if ( specs && specs->field_unsigned ) {
+            std::snprintf( buf, sizeof buf, "%lu", static_cast<unsigned long>( value ) );
+        } else {
+            std::snprintf( buf, sizeof buf, "%ld", value );
+        }
+
+        return node.text().set( buf );
+    }
+
+    if ( op == &asn_OP_NativeEnumerated ) {
+        // XER writes the identifier as an empty element: <value/>.
+        const asn_INTEGER_specifics_t* specs = static_cast<const asn_INTEGER_specifics_t*>( td->specifics );
+        const asn_INTEGER_enum_map_t* entry = INTEGER_map_value2enum( specs, *static_cast<const long*>( sptr ) );
+        if ( !entry ) return fail( td );
+
+        return static_cast<bool>( node.append_child( entry->enum_name ) );
+    }
+
+    if ( op == &asn_OP_BOOLEAN ) {
+        return static_cast<bool>( node.append_child( *static_cast<const BOOLEAN_t*>( sptr ) ? "true" : "false" ) );
+    }
+
+    return fill_encoded( node, td, sptr );
+}
+
+bool asn1_dom::Builder::fill_member( pugi::xml_node node, const asn_TYPE_member_t& elm, const void* sptr, const Projection* projection ) {
+    // an absent OPTIONAL member, which XER leaves out, or one on no selected path.
+    const void* mptr = asn1_walk::member_value( elm, sptr, projection );
+    if ( !mptr ) return true;
+
+    return fill( node.append_child( elm.name ), elm.type, mptr, projection );
+}
+
+bool asn1_dom::Builder::fill_list( pugi::xml_node node, const asn_TYPE_descriptor_t* td, const void* sptr, const Projection* projection ) {
+    const asn_SET_OF_specifics_t* specs = static_cast<const asn_SET_OF_specifics_t*>( td->specifics );
+    const asn_TYPE_member_t& elm = td->elements[0];
+    const asn_anonymous_sequence_* list = _A_CSEQUENCE_FROM_VOID( sptr );
+
+    // items are wrapped in the member name (or the item type's tag when unnamed), except for lists of bare values like
+    // <true/><false/>.
+    const char* name = specs->as_XMLValueList ? nullptr : ( *elm.name ? elm.name : elm.type->xml_tag );
+
+    projection = asn1_walk::list_step( td, projection );
+    if ( projection == &asn1_walk::nothing ) return true;
+
+    for ( int i = 0; i < list->count; ++i ) {
+        const void* item = list->array[i];
+        if ( !item ) continue;
+
+        if ( !fill( name ? node.append_child( name ) : node, elm.type, item, projection ) ) return false;
+    }
+
+    return true;
+}
+
+bool asn1_dom::Builder::fill_encoded( pugi::xml_node node, const asn_TYPE_descriptor_t* td, const void* sptr ) {
+    scratch_.clear();
+
+    asn_enc_rval_t rval = td->op->xer_encoder( td, sptr, 1, XER_F_CANONICAL, asn1_walk::append_to_string, &scratch_ );
+    if ( rval.encoded == -1 ) return fail( rval.failed_type ? rval.failed_type : td );
+
+    if ( scratch_.empty() ) return true;
+
+    // most leaves (hex, bit strings, plain strings) are character data that needs no unescaping.
+    if ( scratch_.find_first_of( "<&" ) == std::string::npos ) {
+        return node.text().set( scratch_.c_str() );
+    }
+
+    pugi::xml_parse_result result = node.append_buffer( scratch_.data(), scratch_.size(), pugi::parse_default );
+    return result ? true : fail( td );
+}
+
+bool asn1_dom::Builder::fail( const asn_TYPE_descriptor_t* td ) {
+    failed_type_ = td;
+    return false;
+}
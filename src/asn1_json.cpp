@@ -0,0 +1,224 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#include "asn1_json.hpp"
+#include "asn1_walk.hpp"
+
+#include "rapidjson/writer.h"
+
+#include <vector>
+
+namespace {
+
+/**
+ * rapidjson output stream that appends to a std::string.
+ */
+struct StringStream {
+    typedef char Ch;
+
+    std::string& s;
+
+    void Put( char c ) {
+        s.push_back( c );
+    }
+
+    void Flush() {}
+};
+
+/**
+ * rapidjson output stream that writes to a pugi::xml_writer (e.g., an OutputBuffer) in chunks.
+ */
+class XmlWriterStream {
+    public:
+        typedef char Ch;
+
+        explicit XmlWriterStream( pugi::xml_writer& output ) :
+            output_( output )
+            , size_{ 0 }
+        {}
+
+        void Put( char c ) {
+            if ( size_ == sizeof buffer_ ) Flush();
+            buffer_[ size_++ ] = c;
+        }
+
+        void Flush() {
+            if ( size_ ) output_.write( buffer_, size_ );
+            size_ = 0;
+        }
+
+    private:
+        pugi::xml_writer& output_;
+        char buffer_[ 1024 ];
+        std::size_t size_;
+};
+
+/**
+ * The content of an element: raw JSON, an object of its child elements, or its text.
+ */
+template<typename Json>
+void write_content( Json& json, pugi::xml_node node, pugi::xml_node raw_node, const std::string& raw_json ) {
+    if ( node == raw_node && !raw_json.empty() ) {
+        json.RawValue( raw_json.data(), raw_json.size(), rapidjson::kObjectType );
+        return;
+    }
+
+    // each name once, in order of first appearance; repeats become an array.
+    std::vector<const char*> names;
+    asn1_walk::element_names( node, names );
+
+    if ( names.empty() ) {
+        json.String( node.child_value() );
+        return;
+    }
+
+    json.StartObject();
+    for ( const char* name : names ) {
+        pugi::xml_node child = node.child( name );
+        json.Key( name );
+        if ( !child.next_sibling( name ) ) {
+            write_content( json, child, raw_node, raw_json );
+            continue;
+        }
+
+        json.StartArray();
+        for ( pugi::xml_node item = child; item; item = item.next_sibling( name ) ) {
+            write_content( json, item, raw_node, raw_json );
+        }
+        json.EndArray();
+    }
+    json.EndObject();
+}
+
+}  // end namespace.
+
+namespace asn1_json {
+
+/**
+ * Writes what asn1_walk::Walker finds behind Writer::append; it is a class so it can use the writer's scratch buffer.
+ */
+class Encoder {
+    public:
+
+        static constexpr bool sized = false;
+
+        Encoder( Writer& writer, std::string& out ) :
+            writer_( writer )
+            , stream_{ out }
+            , json_{ stream_ }
+        {}
+
+        bool start_map( std::size_t ) {
+            return json_.StartObject();
+        }
+
+        bool end_map() {
+            return json_.EndObject();
+        }
+
+        bool start_array( std::size_t ) {
+            return json_.StartArray();
+        }
+
+        bool end_array() {
+            return json_.EndArray();
+        }
+
+        bool key( const char* name ) {
+            return json_.Key( name );
+        }
+
+        bool integer( long v ) {
+            return json_.Int64( v );
+        }
+
+        bool unsigned_integer( unsigned long v ) {
+            return json_.Uint64( v );
+        }
+
+        bool identifier( const char* name ) {
+            return json_.String( name );
+        }
+
+        bool boolean( bool v ) {
+            return json_.Bool( v );
+        }
+
+        bool null() {
+            return json_.Null();
+        }
+
+        /**
+         * Any other leaf: its text (see asn1_walk::leaf_text), as a number for an INTEGER in decimal.
+         */
+        bool leaf( const asn_TYPE_descriptor_t* td, const void* sptr ) {
+            asn1_walk::Leaf leaf;
+            const asn_TYPE_descriptor_t* failed = asn1_walk::leaf_text( td, sptr, writer_.scratch_, leaf );
+            if ( failed ) return fail( failed );
+
+            if ( leaf.kind == asn1_walk::Leaf::Kind::NUMBER ) {
+                return json_.RawNumber( leaf.data, static_cast<rapidjson::SizeType>( leaf.size ) );
+            }
+
+            // the writer checks the encoding, so a malformed character string cannot make invalid JSON.
+            if ( !json_.String( leaf.data, static_cast<rapidjson::SizeType>( leaf.size ) ) ) return fail( td );
+            return true;
+        }
+
+        bool fail( const asn_TYPE_descriptor_t* td ) {
+            writer_.failed_type_ = td;
+            return false;
+        }
+
+    private:
+
+        Writer& writer_;
+        StringStream stream_;
+        rapidjson::Writer<StringStream, rapidjson::UTF8<>, rapidjson::UTF8<>, rapidjson::CrtAllocator, rapidjson::kWriteValidateEncodingFlag> json_;
+};
+
+}  // end namespace.
+
+bool asn1_json::Writer::append( std::string& out, const asn_TYPE_descriptor_t* td, const void* sptr, const Projection* projection ) {
+    failed_type_ = nullptr;
+
+    Encoder encoder{ *this, out };
+    asn1_walk::Walker<Encoder> walker{ encoder };
+    encoder.start_map( 1 );
+    encoder.key( td->xml_tag );
+    if ( !walker.value( td, sptr, projection && !projection->whole() ? projection : nullptr ) ) return false;
+    return encoder.end_map();
+}
+
+void asn1_json::write_document( const pugi::xml_document& doc, pugi::xml_writer& output, pugi::xml_node raw_node, const std::string& raw_json ) {
+    XmlWriterStream stream{ output };
+    rapidjson::Writer<XmlWriterStream> json{ stream };
+
+    pugi::xml_node root = doc.document_element();
+    if ( root ) {
+        write_content( json, root, raw_node, raw_json );
+    } else {
+        json.StartObject();
+        json.EndObject();
+    }
+
+    stream.Flush();
+}
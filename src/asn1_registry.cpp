@@ -0,0 +1,35 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#include "asn1_registry.hpp"
+
+Asn1Registry::Asn1Registry( asn_TYPE_descriptor_t* const* collection ) :
+    types_{}
+{
+    for ( ; collection && *collection; ++collection ) {
+        const asn_TYPE_descriptor_t* td = *collection;
+
+        auto result = types_.emplace( td->name, td );
+        if ( !result.second && td->elements_count > result.first->second->elements_count ) {
+            result.first->second = td;
+        }
+    }
+}
@@ -0,0 +1,200 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#include "asn1_walk.hpp"
+
+#include "BIT_STRING.h"
+#include "IA5String.h"
+#include "INTEGER.h"
+#include "OCTET_STRING.h"
+#include "UTF8String.h"
+#include "VisibleString.h"
+
+#include <cstdio>
+#include <cstring>
+
+const Projection asn1_walk::nothing{};
+
+const Projection* asn1_walk::step( const Projection* projection, const char* name ) {
+    projection = projection->child( name );
+    if ( !projection ) return &nothing;
+    return projection->whole() ? nullptr : projection;
+}
+
+int asn1_walk::append_to_string( const void* buffer, size_t size, void* app_key ) {
+    static_cast<std::string*>( app_key )->append( static_cast<const char*>( buffer ), size );
+    return 0;
+}
+
+void asn1_walk::unescape( std::string& text ) {
+    static const struct { const char* escape; char c; } escapes[] = { { "&lt;", '<' }, { "&gt;", '>' }, { "&amp;", '&' } };
+
+    std::size_t i = text.find( '&' );
+    if ( i == std::string::npos ) return;
+
+    // the text only shrinks, so it is rewritten in place behind the read position.
+    std::size_t out = i;
+    while ( i < text.size() ) {
+        bool replaced = false;
+        if ( text[i] == '&' ) {
+            for ( const auto& e : escapes ) {
+                std::size_t n = std::strlen( e.escape );
+                if ( text.compare( i, n, e.escape ) == 0 ) {
+                    text[ out++ ] = e.c;
+                    i += n;
+                    replaced = true;
+                    break;
+                }
+            }
+        }
+        if ( !replaced ) text[ out++ ] = text[ i++ ];
+    }
+
+    text.resize( out );
+}
+
+const asn_TYPE_descriptor_t* asn1_walk::leaf_text( const asn_TYPE_descriptor_t* td, const void* sptr, std::string& scratch, Leaf& leaf ) {
+    const asn_TYPE_operation_t* op = td->op;
+
+    leaf.kind = Leaf::Kind::TEXT;
+
+    if ( op == &asn_OP_UTF8String || op == &asn_OP_IA5String || op == &asn_OP_VisibleString ) {
+        const OCTET_STRING_t* text = static_cast<const OCTET_STRING_t*>( sptr );
+        leaf.data = text->buf ? reinterpret_cast<const char*>( text->buf ) : "";
+        leaf.size = text->size;
+        return nullptr;
+    }
+
+    if ( op == &asn_OP_OCTET_STRING ) {
+        static const char digits[] = "0123456789ABCDEF";
+        const OCTET_STRING_t* octets = static_cast<const OCTET_STRING_t*>( sptr );
+
+        scratch.resize( 2 * octets->size );
+        for ( std::size_t i = 0; i < octets->size; ++i ) {
+            scratch[ 2 * i ] = digits[ octets->buf[i] >> 4 ];
+            scratch[ 2 * i + 1 ] = digits[ octets->buf[i] & 0x0F ];
+        }
+
+        leaf.data = scratch.data();
+        leaf.size = scratch.size();
+        return nullptr;
+    }
+
+    if ( op == &asn_OP_BIT_STRING ) {
+        // every bit of every octet but the last, which is missing its unused bits.
+        const BIT_STRING_t* bits = static_cast<const BIT_STRING_t*>( sptr );
+
+        scratch.clear();
+        for ( std::size_t i = 0; i < bits->size; ++i ) {
+            int last = ( i + 1 == bits->size ) ? bits->bits_unused : 0;
+            for ( int b = 7; b >= last; --b ) {
+                scratch.push_back( ( bits->buf[i] >> b ) & 1 ? '1' : '0' );
+            }
+        }
+
+        leaf.data = scratch.data();
+        leaf.size = scratch.size();
+        return nullptr;
+    }
+
+    if ( op == &asn_OP_INTEGER ) {
+        const asn_INTEGER_specifics_t* specs = static_cast<const asn_INTEGER_specifics_t*>( td->specifics );
+        const INTEGER_t* integer = static_cast<const INTEGER_t*>( sptr );
+        char buf[ 32 ];
+        long v;
+        unsigned long u;
+        int n = -1;
+
+        if ( specs && specs->field_unsigned && asn_INTEGER2ulong( integer, &u ) == 0 ) {
+            n = std::snprintf( buf, sizeof buf, "%lu", u );
+        } else if ( asn_INTEGER2long( integer, &v ) == 0 ) {
+            n = std::snprintf( buf, sizeof buf, "%ld", v );
+        }
+
+        if ( n > 0 ) {
+            scratch.assign( buf, n );
+            leaf.kind = Leaf::Kind::NUMBER;
+            leaf.data = scratch.data();
+            leaf.size = scratch.size();
+            return nullptr;
+        }
+    }
+
+    scratch.clear();
+    asn_enc_rval_t rval = op->xer_encoder( td, sptr, 1, XER_F_CANONICAL, append_to_string, &scratch );
+    if ( rval.encoded == -1 ) return rval.failed_type ? rval.failed_type : td;
+
+    if ( scratch.size() > 3 && scratch.front() == '<' && scratch.compare( scratch.size() - 2, 2, "/>" ) == 0 ) {
+        leaf.kind = Leaf::Kind::IDENTIFIER;
+        leaf.data = scratch.data() + 1;
+        leaf.size = scratch.size() - 3;
+        return nullptr;
+    }
+
+    unescape( scratch );
+
+    // XER writes an INTEGER too large for intmax_t as hex octets, which is not a number.
+    if ( op == &asn_OP_INTEGER && !scratch.empty() && scratch.find_first_not_of( "-0123456789" ) == std::string::npos ) {
+        leaf.kind = Leaf::Kind::NUMBER;
+    }
+
+    leaf.data = scratch.data();
+    leaf.size = scratch.size();
+    return nullptr;
+}
+
+const void* asn1_walk::member_value( const asn_TYPE_member_t& elm, const void* sptr, const Projection*& projection ) {
+    if ( projection ) {
+        projection = step( projection, elm.name );
+        if ( projection == &nothing ) return nullptr;
+    }
+
+    const void* mptr = static_cast<const char*>( sptr ) + elm.memb_offset;
+    if ( elm.flags & ATF_POINTER ) mptr = *static_cast<const void* const*>( mptr );
+
+    // the list's items are the next step, so it can be left out before anything of it is written.
+    const asn_TYPE_operation_t* op = elm.type->op;
+    if ( mptr && ( op == &asn_OP_SEQUENCE_OF || op == &asn_OP_SET_OF ) && list_step( elm.type, projection ) == &nothing ) {
+        return nullptr;
+    }
+
+    return mptr;
+}
+
+const Projection* asn1_walk::list_step( const asn_TYPE_descriptor_t* td, const Projection* projection ) {
+    const asn_SET_OF_specifics_t* specs = static_cast<const asn_SET_OF_specifics_t*>( td->specifics );
+    const asn_TYPE_member_t& elm = td->elements[0];
+
+    if ( !projection || specs->as_XMLValueList ) return projection;
+    return step( projection, *elm.name ? elm.name : elm.type->xml_tag );
+}
+
+void asn1_walk::element_names( pugi::xml_node node, std::vector<const char*>& names ) {
+    names.clear();
+
+    for ( pugi::xml_node child = node.first_child(); child; child = child.next_sibling() ) {
+        if ( child.type() != pugi::node_element ) continue;
+
+        bool seen = false;
+        for ( const char* name : names ) seen = seen || std::strcmp( name, child.name() ) == 0;
+        if ( !seen ) names.push_back( child.name() );
+    }
+}
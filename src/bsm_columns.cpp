@@ -0,0 +1,166 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#include "bsm_columns.hpp"
+
+#include <cstring>
+#include <type_traits>
+
+namespace {
+
+template<typename T> struct ColumnType;
+template<> struct ColumnType<uint8_t>  { static constexpr char code = 'B'; };
+template<> struct ColumnType<int8_t>   { static constexpr char code = 'b'; };
+template<> struct ColumnType<uint16_t> { static constexpr char code = 'H'; };
+template<> struct ColumnType<int16_t>  { static constexpr char code = 'h'; };
+template<> struct ColumnType<uint32_t> { static constexpr char code = 'I'; };
+template<> struct ColumnType<int32_t>  { static constexpr char code = 'i'; };
+
+void put_uint32( std::string& out, uint32_t value ) {
+    for ( int i = 0; i < 4; ++i ) {
+        out.push_back( static_cast<char>( ( value >> ( 8 * i ) ) & 0xFF ) );
+    }
+}
+
+void pad( std::string& out ) {
+    out.append( ( 8 - out.size() % 8 ) % 8, '\0' );
+}
+
+template<typename T>
+void write_column( std::string& out, const char* name, const std::vector<T>& values ) {
+    std::size_t name_size = std::strlen( name );
+    out.push_back( static_cast<char>( name_size ) );
+    out.append( name, name_size );
+    out.push_back( ColumnType<T>::code );
+    pad( out );
+
+    for ( T value : values ) {
+        typename std::make_unsigned<T>::type bits = static_cast<typename std::make_unsigned<T>::type>( value );
+        for ( std::size_t i = 0; i < sizeof( T ); ++i ) {
+            out.push_back( static_cast<char>( ( bits >> ( 8 * i ) ) & 0xFF ) );
+        }
+    }
+    pad( out );
+}
+
+}  // end namespace.
+
+BsmBatch::BsmBatch() :
+    started_{}
+    , id_{}
+    , msg_cnt_{}
+    , sec_mark_{}
+    , lat_{}
+    , long_{}
+    , elev_{}
+    , speed_{}
+    , heading_{}
+    , accel_long_{}
+    , accel_lat_{}
+    , accel_vert_{}
+    , accel_yaw_{}
+    , wheel_brakes_{}
+    , traction_{}
+    , abs_{}
+    , scs_{}
+    , brake_boost_{}
+    , aux_brakes_{}
+{}
+
+void BsmBatch::append( const BSMcoreData_t& core ) {
+    if ( empty() ) started_ = std::chrono::steady_clock::now();
+
+    uint32_t id = 0;
+    for ( std::size_t i = 0; i < core.id.size && i < 4; ++i ) {
+        id = ( id << 8 ) | core.id.buf[i];
+    }
+
+    // a BIT STRING's bits start at the most significant bit of its first octet.
+    const auto& wheels = core.brakes.wheelBrakes;
+    uint8_t wheel_brakes = wheels.size > 0 ? static_cast<uint8_t>( wheels.buf[0] >> 3 ) : 0;
+
+    id_.push_back( id );
+    msg_cnt_.push_back( static_cast<uint8_t>( core.msgCnt ) );
+    sec_mark_.push_back( static_cast<uint16_t>( core.secMark ) );
+    lat_.push_back( static_cast<int32_t>( core.lat ) );
+    long_.push_back( static_cast<int32_t>( core.Long ) );
+    elev_.push_back( static_cast<int32_t>( core.elev ) );
+    speed_.push_back( static_cast<uint16_t>( core.speed ) );
+    heading_.push_back( static_cast<uint16_t>( core.heading ) );
+    accel_long_.push_back( static_cast<int16_t>( core.accelSet.Long ) );
+    accel_lat_.push_back( static_cast<int16_t>( core.accelSet.lat ) );
+    accel_vert_.push_back( static_cast<int8_t>( core.accelSet.vert ) );
+    accel_yaw_.push_back( static_cast<int16_t>( core.accelSet.yaw ) );
+    wheel_brakes_.push_back( wheel_brakes );
+    traction_.push_back( static_cast<uint8_t>( core.brakes.traction ) );
+    abs_.push_back( static_cast<uint8_t>( core.brakes.abs ) );
+    scs_.push_back( static_cast<uint8_t>( core.brakes.scs ) );
+    brake_boost_.push_back( static_cast<uint8_t>( core.brakes.brakeBoost ) );
+    aux_brakes_.push_back( static_cast<uint8_t>( core.brakes.auxBrakes ) );
+}
+
+void BsmBatch::write( std::string& out ) const {
+    static const uint32_t column_count = 18;
+
+    out.assign( "ACMBSMC1", 8 );
+    put_uint32( out, static_cast<uint32_t>( rows() ) );
+    put_uint32( out, column_count );
+
+    write_column( out, "id", id_ );
+    write_column( out, "msgCnt", msg_cnt_ );
+    write_column( out, "secMark", sec_mark_ );
+    write_column( out, "lat", lat_ );
+    write_column( out, "long", long_ );
+    write_column( out, "elev", elev_ );
+    write_column( out, "speed", speed_ );
+    write_column( out, "heading", heading_ );
+    write_column( out, "accelLong", accel_long_ );
+    write_column( out, "accelLat", accel_lat_ );
+    write_column( out, "accelVert", accel_vert_ );
+    write_column( out, "accelYaw", accel_yaw_ );
+    write_column( out, "wheelBrakes", wheel_brakes_ );
+    write_column( out, "traction", traction_ );
+    write_column( out, "abs", abs_ );
+    write_column( out, "scs", scs_ );
+    write_column( out, "brakeBoost", brake_boost_ );
+    write_column( out, "auxBrakes", aux_brakes_ );
+}
+
+void BsmBatch::clear() {
+    id_.clear();
+    msg_cnt_.clear();
+    sec_mark_.clear();
+    lat_.clear();
+    long_.clear();
+    elev_.clear();
+    speed_.clear();
+    heading_.clear();
+    accel_long_.clear();
+    accel_lat_.clear();
+    accel_vert_.clear();
+    accel_yaw_.clear();
+    wheel_brakes_.clear();
+    traction_.clear();
+    abs_.clear();
+    scs_.clear();
+    brake_boost_.clear();
+    aux_brakes_.clear();
+}
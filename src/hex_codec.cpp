@@ -0,0 +1,302 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#include "hex_codec.hpp"
+
+#include <cstdint>
+
+// the vector kernels are compiled with per-function target attributes, so no global -m flags are needed and the binary
+// still runs on cpus without them.
+#if ( defined(__x86_64__) || defined(__i386__) ) && defined(__GNUC__)
+#define ACM_HEX_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const char upper_digits[] = "0123456789ABCDEF";
+
+constexpr uint8_t hex_space = 0x40;
+constexpr uint8_t hex_invalid = 0x80;
+
+/**
+ * The value of every character: 0-15 for hex digits, hex_space for what isspace() accepts, hex_invalid otherwise.
+ */
+struct DecodeTable {
+    uint8_t value[ 256 ];
+
+    DecodeTable() {
+        for ( int c = 0; c < 256; ++c ) value[c] = hex_invalid;
+        for ( int c = '0'; c <= '9'; ++c ) value[c] = static_cast<uint8_t>( c - '0' );
+        for ( int c = 'A'; c <= 'F'; ++c ) value[c] = static_cast<uint8_t>( c - 'A' + 10 );
+        for ( int c = 'a'; c <= 'f'; ++c ) value[c] = static_cast<uint8_t>( c - 'a' + 10 );
+        for ( char c : { ' ', '\t', '\n', '\v', '\f', '\r' } ) value[ static_cast<uint8_t>( c ) ] = hex_space;
+    }
+};
+
+const DecodeTable decode_table;
+
+/**
+ * Where a decode is: the next output byte, whether it is waiting for its low nibble, and how many characters the
+ * vector kernels have converted.
+ */
+struct DecodeState {
+    char* out;
+    bool half;
+    std::size_t vectorized;
+};
+
+bool decode_scalar( const char* hex, std::size_t size, DecodeState& st ) {
+    for ( std::size_t i = 0; i < size; ++i ) {
+        uint8_t d = decode_table.value[ static_cast<uint8_t>( hex[i] ) ];
+        if ( d & hex_invalid ) return false;
+        if ( d & hex_space ) continue;
+
+        if ( st.half ) {
+            *st.out++ |= static_cast<char>( d );
+        } else {
+            *st.out = static_cast<char>( d << 4 );
+        }
+        st.half = !st.half;
+    }
+    return true;
+}
+
+void encode_scalar( const uint8_t* bytes, std::size_t size, char* out ) {
+    for ( std::size_t i = 0; i < size; ++i ) {
+        *out++ = upper_digits[ bytes[i] >> 4 ];
+        *out++ = upper_digits[ bytes[i] & 0x0F ];
+    }
+}
+
+#ifdef ACM_HEX_X86
+
+/**
+ * Decode a block's characters up to its first non-digit, then any whitespace after it and, after an odd number of
+ * digits, the next digit, so the next block starts on a digit pair and can take the vector path again.
+ *
+ * @param first the position of the block's first non-digit.
+ * @return the number of characters consumed, or 0 if one of them is invalid.
+ */
+std::size_t realign( const char* hex, std::size_t size, std::size_t first, DecodeState& st ) {
+    std::size_t n = first + 1;
+    if ( !decode_scalar( hex, n, st ) ) return 0;
+
+    while ( n < size && ( st.half || decode_table.value[ static_cast<uint8_t>( hex[n] ) ] == hex_space ) ) {
+        if ( !decode_scalar( hex + n, 1, st ) ) return 0;
+        ++n;
+    }
+    return n;
+}
+
+/**
+ * The nibbles of 16 characters, and a mask with a bit set for each one that is a hex digit; the nibbles are only
+ * meaningful when every bit is set.
+ */
+__attribute__((target("sse4.1")))
+inline unsigned nibbles_sse( __m128i v, __m128i& nibbles ) {
+    // signed compares: bytes >= 0x80 are negative and fail both ranges.
+    __m128i digit = _mm_and_si128( _mm_cmpgt_epi8( v, _mm_set1_epi8( '0' - 1 ) ), _mm_cmpgt_epi8( _mm_set1_epi8( '9' + 1 ), v ) );
+    __m128i lower = _mm_or_si128( v, _mm_set1_epi8( 0x20 ) );
+    __m128i alpha = _mm_and_si128( _mm_cmpgt_epi8( lower, _mm_set1_epi8( 'a' - 1 ) ), _mm_cmpgt_epi8( _mm_set1_epi8( 'f' + 1 ), lower ) );
+
+    nibbles = _mm_blendv_epi8( _mm_sub_epi8( lower, _mm_set1_epi8( 'a' - 10 ) ), _mm_sub_epi8( v, _mm_set1_epi8( '0' ) ), digit );
+    return static_cast<unsigned>( _mm_movemask_epi8( _mm_or_si128( digit, alpha ) ) );
+}
+
+__attribute__((target("sse4.1")))
+bool decode_sse( const char* hex, std::size_t size, DecodeState& st ) {
+    std::size_t i = 0;
+
+    while ( i + 16 <= size ) {
+        __m128i nibbles;
+        unsigned digits = nibbles_sse( _mm_loadu_si128( reinterpret_cast<const __m128i*>( hex + i ) ), nibbles );
+
+        if ( digits != 0xFFFF ) {
+            std::size_t n = realign( hex + i, size - i, __builtin_ctz( ~digits ), st );
+            if ( n == 0 ) return false;
+            i += n;
+            continue;
+        }
+
+        // each pair of nibbles (high first) becomes hi * 16 + lo in a 16 bit lane, then packs to a byte.
+        __m128i pairs = _mm_maddubs_epi16( nibbles, _mm_set1_epi16( 0x0110 ) );
+        _mm_storel_epi64( reinterpret_cast<__m128i*>( st.out ), _mm_packus_epi16( pairs, pairs ) );
+        st.out += 8;
+        st.vectorized += 16;
+        i += 16;
+    }
+
+    return decode_scalar( hex + i, size - i, st );
+}
+
+__attribute__((target("avx2")))
+bool decode_avx2( const char* hex, std::size_t size, DecodeState& st ) {
+    std::size_t i = 0;
+
+    while ( i + 32 <= size ) {
+        __m256i v = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( hex + i ) );
+        __m256i digit = _mm256_and_si256( _mm256_cmpgt_epi8( v, _mm256_set1_epi8( '0' - 1 ) ), _mm256_cmpgt_epi8( _mm256_set1_epi8( '9' + 1 ), v ) );
+        __m256i lower = _mm256_or_si256( v, _mm256_set1_epi8( 0x20 ) );
+        __m256i alpha = _mm256_and_si256( _mm256_cmpgt_epi8( lower, _mm256_set1_epi8( 'a' - 1 ) ), _mm256_cmpgt_epi8( _mm256_set1_epi8( 'f' + 1 ), lower ) );
+
+        unsigned digits = static_cast<unsigned>( _mm256_movemask_epi8( _mm256_or_si256( digit, alpha ) ) );
+
+        if ( digits != 0xFFFFFFFFu ) {
+            std::size_t n = realign( hex + i, size - i, __builtin_ctz( ~digits ), st );
+            if ( n == 0 ) return false;
+            i += n;
+            continue;
+        }
+
+        __m256i nibbles = _mm256_blendv_epi8( _mm256_sub_epi8( lower, _mm256_set1_epi8( 'a' - 10 ) ), _mm256_sub_epi8( v, _mm256_set1_epi8( '0' ) ), digit );
+        __m256i pairs = _mm256_maddubs_epi16( nibbles, _mm256_set1_epi16( 0x0110 ) );
+        // the pack works within each 128 bit lane; gather the low quadword of both lanes.
+        __m256i packed = _mm256_permute4x64_epi64( _mm256_packus_epi16( pairs, pairs ), 0x08 );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( st.out ), _mm256_castsi256_si128( packed ) );
+        st.out += 16;
+        st.vectorized += 32;
+        i += 32;
+    }
+
+    return decode_scalar( hex + i, size - i, st );
+}
+
+__attribute__((target("sse4.1")))
+void encode_sse( const uint8_t* bytes, std::size_t size, char* out ) {
+    const __m128i digits = _mm_loadu_si128( reinterpret_cast<const __m128i*>( upper_digits ) );
+    const __m128i low4 = _mm_set1_epi8( 0x0F );
+    std::size_t i = 0;
+
+    for ( ; i + 16 <= size; i += 16, out += 32 ) {
+        __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( bytes + i ) );
+        __m128i hi = _mm_shuffle_epi8( digits, _mm_and_si128( _mm_srli_epi16( v, 4 ), low4 ) );
+        __m128i lo = _mm_shuffle_epi8( digits, _mm_and_si128( v, low4 ) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( out ), _mm_unpacklo_epi8( hi, lo ) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( out + 16 ), _mm_unpackhi_epi8( hi, lo ) );
+    }
+
+    encode_scalar( bytes + i, size - i, out );
+}
+
+__attribute__((target("avx2")))
+void encode_avx2( const uint8_t* bytes, std::size_t size, char* out ) {
+    const __m256i digits = _mm256_broadcastsi128_si256( _mm_loadu_si128( reinterpret_cast<const __m128i*>( upper_digits ) ) );
+    const __m256i low4 = _mm256_set1_epi8( 0x0F );
+    std::size_t i = 0;
+
+    for ( ; i + 32 <= size; i += 32, out += 64 ) {
+        __m256i v = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( bytes + i ) );
+        __m256i hi = _mm256_shuffle_epi8( digits, _mm256_and_si256( _mm256_srli_epi16( v, 4 ), low4 ) );
+        __m256i lo = _mm256_shuffle_epi8( digits, _mm256_and_si256( v, low4 ) );
+        // the unpacks interleave within each 128 bit lane: bytes 0-7 and 16-23, and 8-15 and 24-31.
+        __m256i first = _mm256_unpacklo_epi8( hi, lo );
+        __m256i second = _mm256_unpackhi_epi8( hi, lo );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( out ), _mm256_permute2x128_si256( first, second, 0x20 ) );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( out + 32 ), _mm256_permute2x128_si256( first, second, 0x31 ) );
+    }
+
+    encode_sse( bytes + i, size - i, out );
+}
+
+#endif
+
+enum class Kernel { scalar, sse41, avx2 };
+
+Kernel select_kernel() {
+#ifdef ACM_HEX_X86
+    __builtin_cpu_init();
+    if ( __builtin_cpu_supports( "avx2" ) ) return Kernel::avx2;
+    if ( __builtin_cpu_supports( "sse4.1" ) && __builtin_cpu_supports( "ssse3" ) ) return Kernel::sse41;
+#endif
+    return Kernel::scalar;
+}
+
+Kernel kernel() {
+    static const Kernel k = select_kernel();
+    return k;
+}
+
+}  // end namespace.
+
+bool hex_codec::decode( const char* hex, std::size_t size, std::vector<char>& bytes ) {
+    std::size_t vectorized;
+    return decode( hex, size, bytes, vectorized );
+}
+
+bool hex_codec::decode( const char* hex, std::size_t size, std::vector<char>& bytes, std::size_t& vectorized ) {
+    // room for every character being a digit; trimmed to what was written at the end.
+    std::size_t start = bytes.size();
+    bytes.resize( start + size / 2 + 1 );
+
+    DecodeState st{ &bytes[ start ], false, 0 };
+    bool ok;
+
+    switch ( kernel() ) {
+#ifdef ACM_HEX_X86
+        case Kernel::avx2:
+            ok = decode_avx2( hex, size, st );
+            break;
+        case Kernel::sse41:
+            ok = decode_sse( hex, size, st );
+            break;
+#endif
+        default:
+            ok = decode_scalar( hex, size, st );
+            break;
+    }
+
+    bytes.resize( static_cast<std::size_t>( st.out - &bytes[ start ] ) + start + ( st.half ? 1 : 0 ) );
+    vectorized = st.vectorized;
+    return ok;
+}
+
+void hex_codec::encode( const char* bytes, std::size_t size, std::string& hex ) {
+    hex.resize( 2 * size );
+    if ( size == 0 ) return;
+
+    const uint8_t* in = reinterpret_cast<const uint8_t*>( bytes );
+
+    switch ( kernel() ) {
+#ifdef ACM_HEX_X86
+        case Kernel::avx2:
+            encode_avx2( in, size, &hex[0] );
+            break;
+        case Kernel::sse41:
+            encode_sse( in, size, &hex[0] );
+            break;
+#endif
+        default:
+            encode_scalar( in, size, &hex[0] );
+            break;
+    }
+}
+
+const char* hex_codec::kernel_name() {
+    switch ( kernel() ) {
+        case Kernel::avx2:
+            return "avx2";
+        case Kernel::sse41:
+            return "sse4.1";
+        default:
+            return "scalar";
+    }
+}
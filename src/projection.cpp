@@ -0,0 +1,62 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#include "projection.hpp"
+
+#include "utilities.hpp"
+
+bool Projection::add( const std::string& path ) {
+    StrVector steps = string_utilities::split( path, '/' );
+    if ( steps.empty() ) return false;
+
+    for ( const std::string& step : steps ) {
+        if ( step.empty() ) return false;
+    }
+
+    Projection* node = this;
+    for ( const std::string& step : steps ) {
+        // a selected subtree already contains every path below it.
+        if ( node->whole_ ) return true;
+
+        Projection* next = nullptr;
+        for ( auto& c : node->children_ ) {
+            if ( c.first == step ) next = c.second.get();
+        }
+
+        if ( !next ) {
+            node->children_.emplace_back( step, std::unique_ptr<Projection>{ new Projection{} } );
+            next = node->children_.back().second.get();
+        }
+
+        node = next;
+    }
+
+    node->whole_ = true;
+    node->children_.clear();
+    return true;
+}
+
+const Projection* Projection::child( const char* name ) const {
+    for ( const auto& c : children_ ) {
+        if ( c.first == name ) return c.second.get();
+    }
+    return nullptr;
+}
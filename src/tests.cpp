@@ -3,6 +3,10 @@
 
 #include "acm.hpp"
 #include "utilities.hpp"
+#include "asn1_walk.hpp"
+#include "rapidjson/document.h"
+#include "BasicSafetyMessage.h"
+#include "UTF8String.h"
 
 bool loadTestCases( const std::string& case_file, StrVector& case_data ) {
 
@@ -132,3 +136,816 @@ TEST_CASE("ASN1_Codex Tests", "[encoding]" ) {
 
     // TODO check oracles with decoder
 }
+
+TEST_CASE("Partition tracker releases results in order", "[tracker]" ) {
+    std::vector<std::string> ready;
+
+    PartitionTracker<std::string> ordered{ true };
+    ordered.track( 10 );
+    ordered.track( 11 );
+    ordered.track( 13 );                // offsets need not be contiguous (e.g., compacted topics).
+
+    CHECK_FALSE(ordered.complete( 11, "b", ready ));
+    CHECK(ready.empty());
+    CHECK(ordered.committable() == -1);
+
+    CHECK(ordered.complete( 10, "a", ready ));
+    REQUIRE(ready.size() == 2);
+    CHECK(ready[0] == "a");
+    CHECK(ready[1] == "b");
+    CHECK(ordered.committable() == 12);
+    CHECK(ordered.in_flight() == 1);
+
+    // completing an untracked or already completed offset does nothing.
+    ready.clear();
+    CHECK_FALSE(ordered.complete( 12, "x", ready ));
+    CHECK_FALSE(ordered.complete( 10, "x", ready ));
+    CHECK(ready.empty());
+
+    CHECK(ordered.complete( 13, "c", ready ));
+    CHECK(ready.size() == 1);
+    CHECK(ordered.committable() == 14);
+    CHECK(ordered.in_flight() == 0);
+
+    PartitionTracker<std::string> unordered{ false };
+    ready.clear();
+    unordered.track( 0 );
+    unordered.track( 1 );
+
+    CHECK_FALSE(unordered.complete( 1, "b", ready ));
+    REQUIRE(ready.size() == 1);
+    CHECK(ready[0] == "b");
+    CHECK(unordered.committable() == -1);
+
+    CHECK(unordered.complete( 0, "a", ready ));
+    CHECK(ready.size() == 2);
+    CHECK(unordered.committable() == 2);
+}
+
+TEST_CASE("Partition pauses keep a partition's own pause across a global resume", "[tracker]" ) {
+    std::set<int> consumer_paused;              // what the consumer has paused.
+    auto apply = [&consumer_paused]( const std::vector<int>& keys, bool pause ) {
+        for ( int key : keys ) {
+            if ( pause ) {
+                consumer_paused.insert( key );
+            } else {
+                consumer_paused.erase( key );
+            }
+        }
+        return true;
+    };
+
+    PartitionPauses<int> pauses;
+    CHECK(pauses.pause( 1, apply ));
+    CHECK_FALSE(pauses.pause( 1, apply ));
+    CHECK(consumer_paused == std::set<int>{ 1 });
+
+    // backpressure pauses every partition; its end resumes all but the one behind on its own.
+    CHECK(pauses.set_all( { 0, 1, 2 }, true, apply ) == 3);
+    CHECK(pauses.all_paused());
+    CHECK(pauses.set_all( { 0, 1, 2 }, false, apply ) == 2);
+    CHECK_FALSE(pauses.all_paused());
+    CHECK(consumer_paused == std::set<int>{ 1 });
+    CHECK(pauses.paused( 1 ));
+
+    // the partition's own pause still works after the global one.
+    CHECK(pauses.resume( 1, apply ));
+    CHECK(consumer_paused.empty());
+    CHECK(pauses.pause( 1, apply ));
+    CHECK(consumer_paused == std::set<int>{ 1 });
+
+    // a backlog that clears during backpressure leaves the partition paused until all resume.
+    CHECK(pauses.set_all( { 0, 1, 2 }, true, apply ) == 3);
+    CHECK(pauses.resume( 1, apply ));
+    CHECK_FALSE(pauses.paused( 1 ));
+    CHECK(consumer_paused == ( std::set<int>{ 0, 1, 2 } ));
+    CHECK(pauses.set_all( { 0, 1, 2 }, false, apply ) == 3);
+    CHECK(consumer_paused.empty());
+
+    // nothing changes when the consumer refuses.
+    auto refuse = []( const std::vector<int>&, bool ) { return false; };
+    CHECK_FALSE(pauses.pause( 2, refuse ));
+    CHECK_FALSE(pauses.paused( 2 ));
+    CHECK(pauses.set_all( { 0, 1, 2 }, true, refuse ) == -1);
+    CHECK_FALSE(pauses.all_paused());
+
+    // an eager revoke forgets the partitions' own pauses but not the backpressure one.
+    CHECK(pauses.pause( 2, apply ));
+    CHECK(pauses.set_all( { 0, 1, 2 }, true, apply ) == 3);
+    pauses.clear_partitions();
+    CHECK_FALSE(pauses.paused( 2 ));
+    CHECK(pauses.all_paused());
+
+    // the end of a session forgets both, so the next one does not start from stale state.
+    CHECK(pauses.pause( 2, apply ));
+    pauses.clear();
+    CHECK_FALSE(pauses.paused( 2 ));
+    CHECK_FALSE(pauses.all_paused());
+    consumer_paused.clear();
+    CHECK(pauses.set_all( { 0, 1, 2 }, false, apply ) == 3);
+    CHECK(pauses.pause( 2, apply ));
+    CHECK(consumer_paused == std::set<int>{ 2 });
+}
+
+TEST_CASE("SPSC ring is bounded and FIFO across threads", "[pipeline]" ) {
+    SpscRing<int> ring{ 3 };
+    int v = 0;
+
+    REQUIRE(ring.capacity() == 4);      // rounded up to a power of two.
+    CHECK(ring.empty());
+    CHECK_FALSE(ring.try_pop( v ));
+
+    for ( int i = 0; i < 4; ++i ) {
+        CHECK(ring.try_push( int{ i } ));
+    }
+    CHECK_FALSE(ring.try_push( 4 ));
+
+    CHECK(ring.try_pop( v ));
+    CHECK(v == 0);
+    CHECK(ring.try_push( 4 ));
+
+    for ( int i = 1; i <= 4; ++i ) {
+        CHECK(ring.try_pop( v ));
+        CHECK(v == i);
+    }
+    CHECK(ring.empty());
+
+    const int count = 100000;
+    SpscRing<std::unique_ptr<int>> shared{ 64 };
+    std::thread producer{ [&shared]() {
+        Backoff backoff;
+        for ( int i = 0; i < count; ++i ) {
+            std::unique_ptr<int> item{ new int{ i } };
+            while ( !shared.try_push( std::move( item ) ) ) backoff.pause();
+            backoff.reset();
+        }
+    }};
+
+    std::unique_ptr<int> item;
+    Backoff backoff;
+    bool in_order = true;
+    for ( int i = 0; i < count; ++i ) {
+        while ( !shared.try_pop( item ) ) backoff.pause();
+        backoff.reset();
+        in_order = in_order && item && *item == i;
+    }
+
+    producer.join();
+    CHECK(in_order);
+    CHECK(shared.empty());
+}
+
+TEST_CASE("Stealing queue hands each item to exactly one consumer", "[pipeline]" ) {
+    StealingQueue<int> queue{ 2 };
+    int v = 0;
+
+    CHECK(queue.try_push( 1 ));
+    CHECK(queue.try_push( 2 ));
+    CHECK_FALSE(queue.try_push( 3 ));
+    CHECK(queue.size() == 2);
+    CHECK(queue.try_pop( v ));
+    CHECK(v == 1);
+    CHECK(queue.try_pop( v ));
+    CHECK(v == 2);
+    CHECK_FALSE(queue.try_pop( v ));
+
+    const int count = 100000;
+    const int consumers = 3;
+    StealingQueue<std::unique_ptr<int>> shared{ 64 };
+    std::vector<std::vector<int>> taken( consumers );
+    std::atomic<bool> done{ false };
+    std::vector<std::thread> threads;
+
+    for ( int c = 0; c < consumers; ++c ) {
+        threads.emplace_back( [&shared, &taken, &done, c]() {
+            std::unique_ptr<int> item;
+            Backoff backoff;
+            while ( true ) {
+                bool draining = done;
+                if ( shared.try_pop( item ) ) {
+                    taken[c].push_back( *item );
+                    backoff.reset();
+                } else if ( draining ) {
+                    break;
+                } else {
+                    backoff.pause();
+                }
+            }
+        });
+    }
+
+    Backoff backoff;
+    for ( int i = 0; i < count; ++i ) {
+        std::unique_ptr<int> item{ new int{ i } };
+        while ( !shared.try_push( std::move( item ) ) ) backoff.pause();
+        backoff.reset();
+    }
+    done = true;
+
+    for ( auto& t : threads ) t.join();
+
+    std::vector<int> all;
+    bool fifo = true;
+    for ( auto& items : taken ) {
+        fifo = fifo && std::is_sorted( items.begin(), items.end() );
+        all.insert( all.end(), items.begin(), items.end() );
+    }
+    std::sort( all.begin(), all.end() );
+
+    CHECK(fifo);
+    REQUIRE(all.size() == static_cast<std::size_t>( count ));
+    CHECK(all.front() == 0);
+    CHECK(all.back() == count - 1);
+    CHECK(std::adjacent_find( all.begin(), all.end() ) == all.end());
+}
+
+TEST_CASE("CPU lists are parsed like the kernel writes them", "[affinity]" ) {
+    affinity::CpuList cpus;
+
+    CHECK(affinity::parse_cpu_list( "2-5", cpus ));
+    CHECK(cpus == affinity::CpuList({ 2, 3, 4, 5 }));
+
+    CHECK(affinity::parse_cpu_list( "8, 0,2-3,3", cpus ));
+    CHECK(cpus == affinity::CpuList({ 0, 2, 3, 8 }));
+
+    // malformed lists leave the previous result alone.
+    CHECK_FALSE(affinity::parse_cpu_list( "", cpus ));
+    CHECK_FALSE(affinity::parse_cpu_list( "5-2", cpus ));
+    CHECK_FALSE(affinity::parse_cpu_list( "1-x", cpus ));
+    CHECK_FALSE(affinity::parse_cpu_list( "a", cpus ));
+    CHECK(cpus == affinity::CpuList({ 0, 2, 3, 8 }));
+
+    CHECK(affinity::intersect( cpus, affinity::CpuList({ 1, 2, 8, 9 }) ) == affinity::CpuList({ 2, 8 }));
+    CHECK(affinity::pin_current_thread( affinity::CpuList{} ));
+}
+
+static int append_xer( const void* buffer, size_t size, void* app_key ) {
+    static_cast<std::string*>( app_key )->append( static_cast<const char*>( buffer ), size );
+    return 0;
+}
+
+TEST_CASE("DOM builder writes the same document as the XER encoder", "[decoding]" ) {
+    const char *BSM_HEX = "001480AD562FA8400039E8E717090F9665FE1BACC37FFFFFFFF0003BBAFDFA1FA1007FFF8000000000020214C1C100417FFFFFFE824E100A3FFFFFFFE8942102047FFFFFFE922A1026A40143FFE95D610423405D7FFEA75610322C0599FFEADFA10391C06B5FFEB7E6103CB40A03FFED2121033BC08ADFFED9A6102E8408E5FFEDE2E102BDC0885FFEDF0A1000BC019BFFF7F321FFFFC005DFFFC55A1FFFFFFFFFFFFDD1A100407FFFFFFFE1A2FFFE0000";
+
+    std::vector<char> bytes;
+    for ( const char* p = BSM_HEX; p[0] && p[1]; p += 2 ) {
+        bytes.push_back( static_cast<char>( std::stoi( std::string( p, 2 ), nullptr, 16 ) ) );
+    }
+
+    MessageFrame_t *messageframe = 0;
+    asn_dec_rval_t rval = asn_decode( 0, ATS_UNALIGNED_BASIC_PER, &asn_DEF_MessageFrame, (void **)&messageframe, bytes.data(), bytes.size() );
+    REQUIRE(rval.code == RC_OK);
+
+    std::string xer;
+    CHECK(xer_encode( &asn_DEF_MessageFrame, messageframe, XER_F_CANONICAL, append_xer, &xer ).encoded != -1);
+    pugi::xml_document xer_doc;
+    CHECK(xer_doc.load_buffer( xer.data(), xer.size() ));
+
+    pugi::xml_document built_doc;
+    asn1_dom::Builder builder;
+    pugi::xml_node built = builder.append( built_doc, &asn_DEF_MessageFrame, messageframe );
+    ASN_STRUCT_FREE(asn_DEF_MessageFrame, messageframe);
+    REQUIRE(built);
+
+    std::ostringstream expected, actual;
+    xer_doc.document_element().print( expected, "", pugi::format_raw );
+    built.print( actual, "", pugi::format_raw );
+    CHECK(actual.str() == expected.str());
+    CHECK(built.child("value").child("BasicSafetyMessage").child("coreData"));
+}
+
+TEST_CASE("Output splice copies the envelope and replaces the payload", "[output]" ) {
+    const std::string input =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<OdeAsn1Data>\n"
+        "  <metadata><request a=\"x > y\"><rsus><rsu>10.0.0.1</rsu></rsus></request></metadata>\n"
+        "  <payload>\n"
+        "    <dataType>us.dot.its.jpo.ode.model.OdeHexByteArray</dataType>\n"
+        "    <data><MessageFrame><bytes>0014</bytes></MessageFrame></data>\n"
+        "  </payload>\n"
+        "</OdeAsn1Data>\n";
+
+    pugi::xml_document doc;
+    REQUIRE(doc.load_buffer( input.data(), input.size(), pugi::parse_default | pugi::parse_declaration | pugi::parse_doctype | pugi::parse_trim_pcdata ));
+
+    pugi::xml_node data = doc.child("OdeAsn1Data").child("payload").child("data");
+    XmlSplice splice;
+    splice.reset( input.data(), input.size() );
+    CHECK(splice.replace_content( data ));
+    CHECK(splice.replace_content( data.parent().child("dataType") ));
+    CHECK_FALSE(splice.replace_content( data.child("MessageFrame") ));   // inside a replaced element.
+    REQUIRE_FALSE(splice.valid());
+
+    splice.reset( input.data(), input.size() );
+    CHECK(splice.replace_content( data ));
+    CHECK(splice.replace_content( data.parent().child("dataType") ));
+    REQUIRE(splice.valid());
+
+    data.remove_child("MessageFrame");
+    data.append_child("MessageFrame").append_child("messageId").text().set("20");
+    data.parent().child("dataType").text().set("us.dot.its.jpo.ode.model.OdeXml");
+
+    std::ostringstream spliced;
+    pugi::xml_writer_stream writer{ spliced };
+    splice.write( writer );
+
+    std::string expected = input;
+    expected.replace( expected.find("<MessageFrame><bytes>0014</bytes></MessageFrame>"), 48, "<MessageFrame><messageId>20</messageId></MessageFrame>" );
+    expected.replace( expected.find("OdeHexByteArray"), 15, "OdeXml" );
+    CHECK(spliced.str() == expected);
+}
+
+TEST_CASE("ASN.1 registry finds PDUs by name", "[registry]" ) {
+    Asn1Registry registry{ asn_pdu_collection };
+
+    CHECK(registry.find("MessageFrame") == &asn_DEF_MessageFrame);
+    CHECK(registry.find("Ieee1609Dot2Data") == &asn_DEF_Ieee1609Dot2Data);
+    CHECK(registry.find("AdvisorySituationData") == &asn_DEF_AdvisorySituationData);
+    CHECK(registry.find("NoSuchType") == nullptr);
+
+    // colliding names resolve to the type with the most elements, whatever the order.
+    asn_TYPE_descriptor_t field = asn_DEF_MessageFrame;
+    field.elements_count = 0;
+
+    asn_TYPE_descriptor_t* field_first[] = { &field, &asn_DEF_MessageFrame, nullptr };
+    asn_TYPE_descriptor_t* field_last[] = { &asn_DEF_MessageFrame, &field, nullptr };
+    CHECK(Asn1Registry{ field_first }.find("MessageFrame") == &asn_DEF_MessageFrame);
+    CHECK(Asn1Registry{ field_last }.find("MessageFrame") == &asn_DEF_MessageFrame);
+    CHECK(Asn1Registry{ field_last }.size() == 1);
+}
+
+TEST_CASE("Encode buffer keeps its memory and sizes itself by type", "[encoding]" ) {
+    EncodeBuffer buffer;
+    std::string bytes( 1000, 'x' );
+
+    buffer.prepare( &asn_DEF_MessageFrame );
+    REQUIRE(EncodeBuffer::append( bytes.data(), bytes.size(), &buffer ) == 0);
+    REQUIRE(EncodeBuffer::append( "yz", 2, &buffer ) == 0);
+    CHECK(buffer.size() == 1002);
+    CHECK(std::string( buffer.data(), buffer.size() ) == bytes + "yz");
+    buffer.finish( &asn_DEF_MessageFrame );
+
+    // the next encoding of the type fits without growing.
+    std::size_t capacity = buffer.capacity();
+    buffer.prepare( &asn_DEF_MessageFrame );
+    CHECK(buffer.size() == 0);
+    CHECK(buffer.capacity() >= 1002);
+    REQUIRE(EncodeBuffer::append( bytes.data(), bytes.size(), &buffer ) == 0);
+    CHECK(buffer.capacity() == capacity);
+
+    // a smaller type never shrinks it.
+    buffer.prepare( &asn_DEF_Ieee1609Dot2Data );
+    CHECK(buffer.capacity() == capacity);
+
+    // more than can be had fails the encoding instead of throwing through the C encoder.
+    REQUIRE(EncodeBuffer::append( "yz", 2, &buffer ) == 0);
+    CHECK(EncodeBuffer::append( bytes.data(), std::numeric_limits<std::size_t>::max() / 4, &buffer ) == -1);
+    CHECK(EncodeBuffer::append( bytes.data(), std::numeric_limits<std::size_t>::max(), &buffer ) == -1);
+    CHECK(buffer.size() == 2);
+    CHECK(buffer.capacity() == capacity);
+}
+
+TEST_CASE("Decode arena grows in place, resets, and falls back to the heap", "[arena]" ) {
+    asn_arena_t* arena = asn_arena_create( 256 );
+    REQUIRE(arena);
+
+    // without an arena in use the allocation functions are the C library's.
+    void* heap = asn_arena_malloc( 16 );
+    REQUIRE(heap);
+    CHECK(asn_arena_used( arena ) == 0);
+
+    char* first = nullptr;
+    {
+        ArenaScope scope{ arena };
+
+        first = static_cast<char*>( asn_arena_calloc( 4, 8 ) );
+        REQUIRE(first);
+        CHECK(std::count( first, first + 32, 0 ) == 32);
+        std::size_t used = asn_arena_used( arena );
+        CHECK(used >= 32);
+
+        // the latest allocation grows in place.
+        std::memset( first, 'a', 32 );
+        char* grown = static_cast<char*>( asn_arena_realloc( first, 64 ) );
+        CHECK(grown == first);
+        CHECK(asn_arena_used( arena ) == used + 32);
+        std::memset( grown + 32, 'b', 32 );
+
+        // an earlier one is copied and keeps its contents; freeing arena memory does nothing.
+        REQUIRE(asn_arena_malloc( 16 ));
+        char* moved = static_cast<char*>( asn_arena_realloc( grown, 128 ) );
+        REQUIRE(moved);
+        CHECK(moved != grown);
+        CHECK(std::string( moved, 64 ) == std::string( 32, 'a' ) + std::string( 32, 'b' ));
+        asn_arena_free( moved );
+
+        // more than a block gets a block of its own.
+        CHECK(asn_arena_malloc( 1024 ));
+
+        // heap memory is still reallocated and freed by the C library.
+        heap = asn_arena_realloc( heap, 32 );
+        REQUIRE(heap);
+
+        used = asn_arena_used( arena );
+        {
+            ArenaScope none{ nullptr };
+            void* p = asn_arena_malloc( 8 );
+            CHECK(asn_arena_used( arena ) == used);
+            asn_arena_free( p );
+        }
+
+        // the outer arena is back in use.
+        CHECK(asn_arena_malloc( 8 ));
+        CHECK(asn_arena_used( arena ) > used);
+    }
+
+    // and gone when its scope is left.
+    std::size_t used = asn_arena_used( arena );
+    void* p = asn_arena_malloc( 8 );
+    CHECK(asn_arena_used( arena ) == used);
+    asn_arena_free( p );
+    asn_arena_free( heap );
+
+    // a reset releases everything and reuses the first block.
+    asn_arena_reset( arena );
+    CHECK(asn_arena_used( arena ) == 0);
+    {
+        ArenaScope scope{ arena };
+        CHECK(asn_arena_malloc( 16 ) == first);
+    }
+
+    asn_arena_destroy( arena );
+}
+
+TEST_CASE("Hex conversion skips whitespace and round trips", "[hex]" ) {
+    std::vector<char> bytes;
+
+    CHECK(hex_codec::decode( " 00 1f\n\tAb", 10, bytes ));
+    CHECK(bytes == std::vector<char>({ 0x00, 0x1F, static_cast<char>( 0xAB ) }));
+
+    // appends; an odd digit count fills only the high nibble of the last byte.
+    CHECK(hex_codec::decode( "c", 1, bytes ));
+    CHECK(bytes.size() == 4);
+    CHECK(bytes.back() == static_cast<char>( 0xC0 ));
+
+    bytes.clear();
+    CHECK(hex_codec::decode( " \r\n", 3, bytes ));
+    CHECK(bytes.empty());
+
+    // long enough for the vector kernels, with a bad character past the first blocks.
+    std::string hex;
+    for ( int i = 0; i < 200; ++i ) hex += "0123456789abcdefABCDEF"[ i % 22 ];
+    std::string bad = hex;
+    bad[ 150 ] = 'g';
+    bytes.clear();
+    CHECK_FALSE(hex_codec::decode( bad.data(), bad.size(), bytes ));
+
+    std::string all;
+    for ( int i = 0; i < 256; ++i ) all.push_back( static_cast<char>( i ) );
+    all += all;
+
+    std::string encoded;
+    hex_codec::encode( all.data(), all.size(), encoded );
+    REQUIRE(encoded.size() == 2 * all.size());
+    CHECK(encoded.compare( 0, 8, "00010203" ) == 0);
+    CHECK(encoded.compare( 2 * 255, 4, "FF00" ) == 0);
+
+    // whitespace anywhere, including inside a vector block, does not change the result.
+    std::string spaced;
+    for ( std::size_t i = 0; i < encoded.size(); ++i ) {
+        spaced.push_back( encoded[i] );
+        if ( i % 37 == 0 ) spaced.push_back( ' ' );
+    }
+
+    bytes.clear();
+    REQUIRE(hex_codec::decode( spaced.data(), spaced.size(), bytes ));
+    CHECK(std::string( bytes.begin(), bytes.end() ) == all);
+
+    // leading whitespace, or an odd digit before it, takes the scalar loop only until the next digit pair.
+    std::string digits = encoded.substr( 0, 64 );
+    std::size_t vectorized;
+    bool vector = std::string( hex_codec::kernel_name() ) != "scalar";
+
+    bytes.clear();
+    REQUIRE(hex_codec::decode( ( " " + digits ).data(), 65, bytes, vectorized ));
+    CHECK(std::string( bytes.begin(), bytes.end() ) == all.substr( 0, 32 ));
+    CHECK(vectorized == ( vector ? 64 : 0 ));
+
+    bytes.clear();
+    REQUIRE(hex_codec::decode( ( "0 0" + digits ).data(), 67, bytes, vectorized ));
+    CHECK(bytes.size() == 33);
+    CHECK(bytes[0] == 0x00);
+    CHECK(std::string( bytes.begin() + 1, bytes.end() ) == all.substr( 0, 32 ));
+    CHECK(vectorized == ( vector ? 64 : 0 ));
+}
+
+TEST_CASE("Constraint policies are parsed from the configuration", "[constraints]" ) {
+    ConstraintPolicy policy;
+    CHECK(policy.mode == ConstraintPolicy::Mode::ALWAYS);
+
+    CHECK(policy.parse("sample:100"));
+    CHECK(policy.mode == ConstraintPolicy::Mode::SAMPLE);
+    CHECK(policy.sample_interval == 100);
+
+    CHECK(policy.parse("encode"));
+    CHECK(policy.mode == ConstraintPolicy::Mode::ENCODE);
+    CHECK(policy.parse("off"));
+    CHECK(policy.mode == ConstraintPolicy::Mode::OFF);
+
+    // a rejected value leaves the policy as it was.
+    CHECK_FALSE(policy.parse("sample:0"));
+    CHECK_FALSE(policy.parse("sample:x"));
+    CHECK_FALSE(policy.parse("sometimes"));
+    CHECK(policy.mode == ConstraintPolicy::Mode::OFF);
+
+    CHECK(policy.parse("always"));
+    CHECK(policy.mode == ConstraintPolicy::Mode::ALWAYS);
+}
+
+TEST_CASE("Leaves read from the structure have the text XER writes", "[output]" ) {
+    const char *BSM_HEX = "001480AD562FA8400039E8E717090F9665FE1BACC37FFFFFFFF0003BBAFDFA1FA1007FFF8000000000020214C1C100417FFFFFFE824E100A3FFFFFFFE8942102047FFFFFFE922A1026A40143FFE95D610423405D7FFEA75610322C0599FFEADFA10391C06B5FFEB7E6103CB40A03FFED2121033BC08ADFFED9A6102E8408E5FFEDE2E102BDC0885FFEDF0A1000BC019BFFF7F321FFFFC005DFFFC55A1FFFFFFFFFFFFDD1A100407FFFFFFFE1A2FFFE0000";
+
+    std::vector<char> bytes;
+    REQUIRE(hex_codec::decode( BSM_HEX, std::strlen( BSM_HEX ), bytes ));
+
+    MessageFrame_t *messageframe = 0;
+    asn_dec_rval_t rval = asn_decode( 0, ATS_UNALIGNED_BASIC_PER, &asn_DEF_MessageFrame, (void **)&messageframe, bytes.data(), bytes.size() );
+    REQUIRE(rval.code == RC_OK);
+
+    const BSMcoreData_t& core = messageframe->value.choice.BasicSafetyMessage.coreData;
+    const struct { const asn_TYPE_descriptor_t* td; const void* sptr; } leaves[] = {
+        { &asn_DEF_TemporaryID, &core.id },                                 // OCTET STRING
+        { &asn_DEF_BrakeAppliedStatus, &core.brakes.wheelBrakes },          // BIT STRING
+    };
+
+    std::string scratch;
+    for ( const auto& l : leaves ) {
+        std::string xer;
+        asn_enc_rval_t erval = l.td->op->xer_encoder( l.td, l.sptr, 1, XER_F_CANONICAL, asn1_walk::append_to_string, &xer );
+        REQUIRE(erval.encoded != -1);
+
+        asn1_walk::Leaf leaf;
+        CHECK(asn1_walk::leaf_text( l.td, l.sptr, scratch, leaf ) == nullptr);
+        CHECK(leaf.kind == asn1_walk::Leaf::Kind::TEXT);
+        CHECK(std::string( leaf.data, leaf.size ) == xer);
+    }
+
+    ASN_STRUCT_FREE(asn_DEF_MessageFrame, messageframe);
+
+    std::string text = "a &lt;b&gt; &amp; c";
+    asn1_walk::unescape( text );
+    CHECK(text == "a <b> & c");
+}
+
+TEST_CASE("JSON writer writes the decoded structure into the envelope", "[output]" ) {
+    const char *BSM_HEX = "001480AD562FA8400039E8E717090F9665FE1BACC37FFFFFFFF0003BBAFDFA1FA1007FFF8000000000020214C1C100417FFFFFFE824E100A3FFFFFFFE8942102047FFFFFFE922A1026A40143FFE95D610423405D7FFEA75610322C0599FFEADFA10391C06B5FFEB7E6103CB40A03FFED2121033BC08ADFFED9A6102E8408E5FFEDE2E102BDC0885FFEDF0A1000BC019BFFF7F321FFFFC005DFFFC55A1FFFFFFFFFFFFDD1A100407FFFFFFFE1A2FFFE0000";
+
+    std::vector<char> bytes;
+    REQUIRE(hex_codec::decode( BSM_HEX, std::strlen( BSM_HEX ), bytes ));
+
+    MessageFrame_t *messageframe = 0;
+    asn_dec_rval_t rval = asn_decode( 0, ATS_UNALIGNED_BASIC_PER, &asn_DEF_MessageFrame, (void **)&messageframe, bytes.data(), bytes.size() );
+    REQUIRE(rval.code == RC_OK);
+
+    std::string payload;
+    asn1_json::Writer writer;
+    bool written = writer.append( payload, &asn_DEF_MessageFrame, messageframe );
+    ASN_STRUCT_FREE(asn_DEF_MessageFrame, messageframe);
+    REQUIRE(written);
+
+    pugi::xml_document envelope;
+    REQUIRE(envelope.load_string( "<OdeAsn1Data><metadata><encodings><encodings><elementType>MessageFrame</elementType></encodings>"
+                "<encodings><elementType>Ieee1609Dot2Data</elementType></encodings></encodings></metadata>"
+                "<payload><dataType>us.dot.its.jpo.ode.model.OdeXml</dataType><data></data></payload></OdeAsn1Data>" ));
+
+    std::ostringstream json;
+    pugi::xml_writer_stream json_writer{ json };
+    asn1_json::write_document( envelope, json_writer, envelope.child("OdeAsn1Data").child("payload").child("data"), payload );
+
+    rapidjson::Document doc;
+    REQUIRE_FALSE(doc.Parse( json.str().c_str() ).HasParseError());
+
+    // repeated elements become an array.
+    REQUIRE(doc["metadata"]["encodings"]["encodings"].IsArray());
+    CHECK(doc["metadata"]["encodings"]["encodings"].Size() == 2);
+    CHECK(std::string{ doc["payload"]["dataType"].GetString() } == "us.dot.its.jpo.ode.model.OdeXml");
+
+    const rapidjson::Value& frame = doc["payload"]["data"]["MessageFrame"];
+    CHECK(frame["messageId"].GetInt() == 20);
+    REQUIRE(frame["value"]["BasicSafetyMessage"]["coreData"].IsObject());
+    CHECK(frame["value"]["BasicSafetyMessage"]["coreData"]["msgCnt"].IsNumber());
+    CHECK(frame["value"]["BasicSafetyMessage"]["coreData"]["id"].IsString());
+
+    // a character string that is not UTF-8 fails the writer instead of making invalid JSON.
+    uint8_t accented[] = { 'a', 0xC3, 0xA9 };
+    uint8_t malformed[] = { 'a', 0xC3, 0x28 };
+    UTF8String_t text{};
+    text.buf = accented;
+    text.size = sizeof accented;
+
+    std::string leaf;
+    REQUIRE(writer.append( leaf, &asn_DEF_UTF8String, &text ));
+    CHECK(leaf == "{\"UTF8String\":\"a\xC3\xA9\"}");
+
+    text.buf = malformed;
+    leaf.clear();
+    CHECK_FALSE(writer.append( leaf, &asn_DEF_UTF8String, &text ));
+    CHECK(writer.failed_type() == &asn_DEF_UTF8String);
+}
+
+TEST_CASE("CBOR writer writes the decoded structure into the envelope", "[output]" ) {
+    const char *BSM_HEX = "001480AD562FA8400039E8E717090F9665FE1BACC37FFFFFFFF0003BBAFDFA1FA1007FFF8000000000020214C1C100417FFFFFFE824E100A3FFFFFFFE8942102047FFFFFFE922A1026A40143FFE95D610423405D7FFEA75610322C0599FFEADFA10391C06B5FFEB7E6103CB40A03FFED2121033BC08ADFFED9A6102E8408E5FFEDE2E102BDC0885FFEDF0A1000BC019BFFF7F321FFFFC005DFFFC55A1FFFFFFFFFFFFDD1A100407FFFFFFFE1A2FFFE0000";
+
+    std::vector<char> bytes;
+    REQUIRE(hex_codec::decode( BSM_HEX, std::strlen( BSM_HEX ), bytes ));
+
+    MessageFrame_t *messageframe = 0;
+    asn_dec_rval_t rval = asn_decode( 0, ATS_UNALIGNED_BASIC_PER, &asn_DEF_MessageFrame, (void **)&messageframe, bytes.data(), bytes.size() );
+    REQUIRE(rval.code == RC_OK);
+
+    std::string cbor;
+    std::string json;
+    asn1_cbor::Writer writer;
+    asn1_json::Writer json_writer;
+    bool written = writer.append( cbor, &asn_DEF_MessageFrame, messageframe );
+    json_writer.append( json, &asn_DEF_MessageFrame, messageframe );
+    ASN_STRUCT_FREE(asn_DEF_MessageFrame, messageframe);
+    REQUIRE(written);
+
+    // {"MessageFrame": {"messageId": 20, "value": {"BasicSafetyMessage": ...
+    const std::string start{ "\xA1\x6CMessageFrame\xA2\x69messageId\x14\x65value\xA1\x72" "BasicSafetyMessage" };
+    CHECK(cbor.compare( 0, start.size(), start ) == 0);
+    CHECK(cbor.size() < json.size());
+
+    // repeated elements become an array; the raw node's content is the given data item (here, true).
+    pugi::xml_document envelope;
+    REQUIRE(envelope.load_string( "<a><b>x</b><c>1</c><c>2</c><d></d></a>" ));
+
+    std::ostringstream out;
+    pugi::xml_writer_stream out_writer{ out };
+    asn1_cbor::write_document( envelope, out_writer, envelope.child("a").child("d"), std::string{ "\xF5" } );
+    CHECK(out.str() == std::string{ "\xA3\x61" "b\x61x\x61" "c\x82\x61" "1\x61" "2\x61" "d\xF5" });
+}
+
+TEST_CASE("Projections write only the selected parts of a decoded PDU", "[decoding]" ) {
+    Projection projection;
+    CHECK_FALSE(projection.add( "value//coreData" ));
+    CHECK(projection.empty());
+    CHECK(projection.add( "value/BasicSafetyMessage/coreData/id" ));
+    CHECK(projection.add( "value/BasicSafetyMessage/coreData" ));
+    REQUIRE(projection.child("value"));
+    CHECK(projection.child("value")->child("BasicSafetyMessage")->child("coreData")->whole());
+    CHECK(projection.child("messageId") == nullptr);
+
+    const char *BSM_HEX = "001480AD562FA8400039E8E717090F9665FE1BACC37FFFFFFFF0003BBAFDFA1FA1007FFF8000000000020214C1C100417FFFFFFE824E100A3FFFFFFFE8942102047FFFFFFE922A1026A40143FFE95D610423405D7FFEA75610322C0599FFEADFA10391C06B5FFEB7E6103CB40A03FFED2121033BC08ADFFED9A6102E8408E5FFEDE2E102BDC0885FFEDF0A1000BC019BFFF7F321FFFFC005DFFFC55A1FFFFFFFFFFFFDD1A100407FFFFFFFE1A2FFFE0000";
+
+    std::vector<char> bytes;
+    REQUIRE(hex_codec::decode( BSM_HEX, std::strlen( BSM_HEX ), bytes ));
+
+    MessageFrame_t *messageframe = 0;
+    asn_dec_rval_t rval = asn_decode( 0, ATS_UNALIGNED_BASIC_PER, &asn_DEF_MessageFrame, (void **)&messageframe, bytes.data(), bytes.size() );
+    REQUIRE(rval.code == RC_OK);
+
+    pugi::xml_document doc;
+    asn1_dom::Builder builder;
+    pugi::xml_node built = builder.append( doc, &asn_DEF_MessageFrame, messageframe, &projection );
+
+    std::string json;
+    asn1_json::Writer writer;
+    bool written = writer.append( json, &asn_DEF_MessageFrame, messageframe, &projection );
+
+    // a list whose items are on no selected path is left out by every writer, as if the list were not selected.
+    REQUIRE(messageframe->value.choice.BasicSafetyMessage.partII);
+    Projection core_only;
+    Projection no_items;
+    REQUIRE(core_only.add( "value/BasicSafetyMessage/coreData" ));
+    REQUIRE(no_items.add( "value/BasicSafetyMessage/coreData" ));
+    REQUIRE(no_items.add( "value/BasicSafetyMessage/partII/none" ));
+
+    pugi::xml_document dom_core;
+    pugi::xml_document dom_no_items;
+    std::string json_core;
+    std::string json_no_items;
+    std::string cbor_core;
+    std::string cbor_no_items;
+    asn1_cbor::Writer cbor_writer;
+    CHECK(builder.append( dom_core, &asn_DEF_MessageFrame, messageframe, &core_only ));
+    CHECK(builder.append( dom_no_items, &asn_DEF_MessageFrame, messageframe, &no_items ));
+    CHECK(writer.append( json_core, &asn_DEF_MessageFrame, messageframe, &core_only ));
+    CHECK(writer.append( json_no_items, &asn_DEF_MessageFrame, messageframe, &no_items ));
+    CHECK(cbor_writer.append( cbor_core, &asn_DEF_MessageFrame, messageframe, &core_only ));
+    CHECK(cbor_writer.append( cbor_no_items, &asn_DEF_MessageFrame, messageframe, &no_items ));
+
+    ASN_STRUCT_FREE(asn_DEF_MessageFrame, messageframe);
+    REQUIRE(built);
+    REQUIRE(written);
+
+    std::ostringstream xml_core;
+    std::ostringstream xml_no_items;
+    dom_core.save( xml_core );
+    dom_no_items.save( xml_no_items );
+    CHECK(xml_no_items.str() == xml_core.str());
+    CHECK(json_no_items == json_core);
+    CHECK(cbor_no_items == cbor_core);
+    CHECK(xml_no_items.str().find( "partII" ) == std::string::npos);
+
+    pugi::xml_node bsm = built.child("value").child("BasicSafetyMessage");
+    CHECK(bsm.child("coreData").child("msgCnt"));
+    CHECK_FALSE(bsm.child("partII"));
+    CHECK_FALSE(built.child("messageId"));
+
+    rapidjson::Document parsed;
+    REQUIRE_FALSE(parsed.Parse( json.c_str() ).HasParseError());
+    const rapidjson::Value& core = parsed["MessageFrame"]["value"]["BasicSafetyMessage"];
+    CHECK(core.MemberCount() == 1);
+    CHECK(core["coreData"]["msgCnt"].IsNumber());
+    CHECK_FALSE(parsed["MessageFrame"].HasMember("messageId"));
+}
+
+TEST_CASE("Skipped members are passed over by the UPER decoder", "[decoding]" ) {
+    std::string error;
+    CHECK_FALSE(uper_skip::skip_member( &asn_DEF_BasicSafetyMessage, "coreData", error ));
+    CHECK_FALSE(error.empty());
+    CHECK_FALSE(uper_skip::skip_member( &asn_DEF_BasicSafetyMessage, "noSuchMember", error ));
+
+    const char *BSM_HEX = "001480AD562FA8400039E8E717090F9665FE1BACC37FFFFFFFF0003BBAFDFA1FA1007FFF8000000000020214C1C100417FFFFFFE824E100A3FFFFFFFE8942102047FFFFFFE922A1026A40143FFE95D610423405D7FFEA75610322C0599FFEADFA10391C06B5FFEB7E6103CB40A03FFED2121033BC08ADFFED9A6102E8408E5FFEDE2E102BDC0885FFEDF0A1000BC019BFFF7F321FFFFC005DFFFC55A1FFFFFFFFFFFFDD1A100407FFFFFFFE1A2FFFE0000";
+
+    std::vector<char> bytes;
+    REQUIRE(hex_codec::decode( BSM_HEX, std::strlen( BSM_HEX ), bytes ));
+
+    asn1_dom::Builder builder;
+    pugi::xml_document full_doc;
+    MessageFrame_t *messageframe = 0;
+    asn_dec_rval_t full = asn_decode( 0, ATS_UNALIGNED_BASIC_PER, &asn_DEF_MessageFrame, (void **)&messageframe, bytes.data(), bytes.size() );
+    REQUIRE(full.code == RC_OK);
+    pugi::xml_node full_bsm = builder.append( full_doc, &asn_DEF_MessageFrame, messageframe ).child("value").child("BasicSafetyMessage");
+    ASN_STRUCT_FREE(asn_DEF_MessageFrame, messageframe);
+
+    REQUIRE(uper_skip::skip_member( &asn_DEF_BasicSafetyMessage, "partII", error ));
+    REQUIRE(uper_skip::skip_member( &asn_DEF_BasicSafetyMessage, "regional", error ));
+
+    pugi::xml_document skipped_doc;
+    messageframe = 0;
+    asn_dec_rval_t skipped = asn_decode( 0, ATS_UNALIGNED_BASIC_PER, &asn_DEF_MessageFrame, (void **)&messageframe, bytes.data(), bytes.size() );
+    uper_skip::restore();
+    REQUIRE(skipped.code == RC_OK);
+    pugi::xml_node skipped_bsm = builder.append( skipped_doc, &asn_DEF_MessageFrame, messageframe ).child("value").child("BasicSafetyMessage");
+    ASN_STRUCT_FREE(asn_DEF_MessageFrame, messageframe);
+
+    CHECK(skipped.consumed == full.consumed);
+    CHECK(full_bsm.child("partII"));
+    CHECK_FALSE(skipped_bsm.child("partII"));
+
+    std::ostringstream full_core, skipped_core;
+    full_bsm.child("coreData").print( full_core, "", pugi::format_raw );
+    skipped_bsm.child("coreData").print( skipped_core, "", pugi::format_raw );
+    CHECK(skipped_core.str() == full_core.str());
+}
+
+TEST_CASE("BSM core data is gathered into columnar batches", "[decoding]" ) {
+    const char *BSM_HEX = "001480AD562FA8400039E8E717090F9665FE1BACC37FFFFFFFF0003BBAFDFA1FA1007FFF8000000000020214C1C100417FFFFFFE824E100A3FFFFFFFE8942102047FFFFFFE922A1026A40143FFE95D610423405D7FFEA75610322C0599FFEADFA10391C06B5FFEB7E6103CB40A03FFED2121033BC08ADFFED9A6102E8408E5FFEDE2E102BDC0885FFEDF0A1000BC019BFFF7F321FFFFC005DFFFC55A1FFFFFFFFFFFFDD1A100407FFFFFFFE1A2FFFE0000";
+
+    std::vector<char> bytes;
+    REQUIRE(hex_codec::decode( BSM_HEX, std::strlen( BSM_HEX ), bytes ));
+
+    MessageFrame_t *messageframe = 0;
+    asn_dec_rval_t rval = asn_decode( 0, ATS_UNALIGNED_BASIC_PER, &asn_DEF_MessageFrame, (void **)&messageframe, bytes.data(), bytes.size() );
+    REQUIRE(rval.code == RC_OK);
+    REQUIRE(messageframe->value.present == MessageFrame__value_PR_BasicSafetyMessage);
+    const BSMcoreData_t& core = messageframe->value.choice.BasicSafetyMessage.coreData;
+
+    BsmBatch batch;
+    batch.append( core );
+    batch.append( core );
+    batch.append( core );
+    CHECK(batch.rows() == 3);
+
+    std::string out;
+    batch.write( out );
+    long msg_cnt = core.msgCnt;
+    long lat = core.lat;
+    ASN_STRUCT_FREE(asn_DEF_MessageFrame, messageframe);
+
+    REQUIRE(out.size() > 16);
+    CHECK(out.compare( 0, 8, "ACMBSMC1" ) == 0);
+    CHECK(out.size() % 8 == 0);
+    CHECK(static_cast<uint8_t>( out[8] ) == 3);
+    CHECK(static_cast<uint8_t>( out[12] ) == 18);
+
+    // the first column is id (uint32), so the second, msgCnt, starts after its header and 3 padded values.
+    std::size_t pos = 16 + 8 + 16;
+    REQUIRE(out.size() > pos + 8);
+    CHECK(out.compare( pos, 8, std::string{ "\x06msgCntB", 8 } ) == 0);
+    CHECK(static_cast<uint8_t>( out[ pos + 8 ] ) == msg_cnt);
+    CHECK(static_cast<uint8_t>( out[ pos + 10 ] ) == msg_cnt);
+
+    // lat is the fourth column: after msgCnt (8 + 8 bytes) and secMark (16 + 8 bytes).
+    pos += 16 + 24;
+    CHECK(out.compare( pos, 5, std::string{ "\x03lati", 5 } ) == 0);
+    int32_t first_lat = static_cast<int32_t>( static_cast<uint8_t>( out[ pos + 8 ] ) | static_cast<uint8_t>( out[ pos + 9 ] ) << 8
+            | static_cast<uint8_t>( out[ pos + 10 ] ) << 16 | static_cast<uint32_t>( static_cast<uint8_t>( out[ pos + 11 ] ) ) << 24 );
+    CHECK(first_lat == lat);
+
+    batch.clear();
+    CHECK(batch.empty());
+}
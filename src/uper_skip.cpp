@@ -0,0 +1,344 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#include "uper_skip.hpp"
+
+#include "BOOLEAN.h"
+#include "ENUMERATED.h"
+#include "INTEGER.h"
+#include "NULL.h"
+#include "NativeEnumerated.h"
+#include "NativeInteger.h"
+#include "OPEN_TYPE.h"
+#include "constr_CHOICE.h"
+#include "constr_SEQUENCE.h"
+#include "constr_SEQUENCE_OF.h"
+#include "constr_SET_OF.h"
+
+#include <memory>
+#include <vector>
+
+namespace {
+
+/**
+ * The descriptor a skipped member points to; td is first so the decoder can find the rest from its descriptor.
+ */
+struct Skipped {
+    asn_TYPE_descriptor_t td;                                           ///< The original's copy with op below.
+    asn_TYPE_operation_t op;                                            ///< The original's operations but for uper_decoder.
+    asn_TYPE_member_t* member;
+    asn_TYPE_descriptor_t* original;
+};
+
+std::vector<std::unique_ptr<Skipped>> skipped_members;
+
+/**
+ * Types nest only a few levels; anything deeper is a recursive type fed with malicious input.
+ */
+const int max_depth = 64;
+
+bool skip( const asn_codec_ctx_t* ctx, const asn_TYPE_descriptor_t* td, const asn_per_constraints_t* constraints, asn_per_data_t* pd, int depth );
+
+asn_dec_rval_t decode_skipped( const asn_codec_ctx_t* ctx, const asn_TYPE_descriptor_t* td, const asn_per_constraints_t* constraints, void** sptr, asn_per_data_t* pd ) {
+    const Skipped* skipped = reinterpret_cast<const Skipped*>( td );
+    asn_dec_rval_t rval;
+
+    // *sptr is left as it is, nullptr: the OPTIONAL member is absent.
+    (void)sptr;
+    rval.code = skip( ctx, skipped->original, constraints, pd, 0 ) ? RC_OK : RC_FAIL;
+    rval.consumed = 0;
+    return rval;
+}
+
+bool skip_bits( asn_per_data_t* pd, std::size_t nbits ) {
+    while ( nbits > 0 ) {
+        int n = nbits > 24 ? 24 : static_cast<int>( nbits );
+        if ( per_get_few_bits( pd, n ) < 0 ) return false;
+        nbits -= n;
+    }
+    return true;
+}
+
+/**
+ * Octets after an unconstrained length determinant, possibly fragmented: open types, extensions and integers that are
+ * not constrained to a range.
+ */
+bool skip_octets( asn_per_data_t* pd ) {
+    int repeat = 0;
+
+    do {
+        ssize_t length = uper_get_length( pd, -1, 0, &repeat );
+        if ( length < 0 || !skip_bits( pd, 8 * static_cast<std::size_t>( length ) ) ) return false;
+    } while ( repeat );
+
+    return true;
+}
+
+/**
+ * The extension bit of a PER visible constraint; when it is set the value is outside the root and the constraint does
+ * not apply.
+ */
+bool read_extension( const asn_per_constraint_t*& ct, asn_per_data_t* pd ) {
+    if ( ct && ( ct->flags & asn_per_constraint_t::APC_EXTENSIBLE ) ) {
+        int32_t extended = per_get_few_bits( pd, 1 );
+        if ( extended < 0 ) return false;
+        if ( extended ) ct = nullptr;
+    }
+    return true;
+}
+
+bool skip_member_value( const asn_codec_ctx_t* ctx, const asn_TYPE_member_t& elm, asn_per_data_t* pd, int depth ) {
+    if ( elm.flags & ATF_OPEN_TYPE ) return skip_octets( pd );
+    return skip( ctx, elm.type, elm.encoding_constraints.per_constraints, pd, depth + 1 );
+}
+
+bool skip_sequence( const asn_codec_ctx_t* ctx, const asn_TYPE_descriptor_t* td, asn_per_data_t* pd, int depth ) {
+    const asn_SEQUENCE_specifics_t* specs = static_cast<const asn_SEQUENCE_specifics_t*>( td->specifics );
+
+    int32_t extended = 0;
+    if ( specs->first_extension >= 0 ) {
+        extended = per_get_few_bits( pd, 1 );
+        if ( extended < 0 ) return false;
+    }
+
+    // the presence bits of the OPTIONAL and DEFAULT root members come first; read them from a copy of the cursor.
+    asn_per_data_t presence = *pd;
+    presence.refill = nullptr;
+    if ( !skip_bits( pd, specs->roms_count ) ) return false;
+
+    unsigned root_count = specs->first_extension < 0 ? td->elements_count : static_cast<unsigned>( specs->first_extension );
+    for ( unsigned i = 0; i < root_count; ++i ) {
+        const asn_TYPE_member_t& elm = td->elements[i];
+
+        if ( elm.optional ) {
+            int32_t present = per_get_few_bits( &presence, 1 );
+            if ( present < 0 ) return false;
+            if ( !present ) continue;
+        }
+
+        if ( !skip_member_value( ctx, elm, pd, depth ) ) return false;
+    }
+
+    if ( !extended ) return true;
+
+    // a bitmap of the extension additions, known to this version or not, then each present one as an open type.
+    ssize_t count = uper_get_nslength( pd );
+    if ( count < 0 ) return false;
+
+    asn_per_data_t additions = *pd;
+    additions.refill = nullptr;
+    if ( !skip_bits( pd, static_cast<std::size_t>( count ) ) ) return false;
+
+    for ( ssize_t i = 0; i < count; ++i ) {
+        int32_t present = per_get_few_bits( &additions, 1 );
+        if ( present < 0 ) return false;
+        if ( present && !skip_octets( pd ) ) return false;
+    }
+
+    return true;
+}
+
+bool skip_choice( const asn_codec_ctx_t* ctx, const asn_TYPE_descriptor_t* td, const asn_per_constraints_t* constraints, asn_per_data_t* pd, int depth ) {
+    const asn_CHOICE_specifics_t* specs = static_cast<const asn_CHOICE_specifics_t*>( td->specifics );
+    const asn_per_constraint_t* ct = constraints ? &constraints->value : nullptr;
+
+    if ( !read_extension( ct, pd ) ) return false;
+
+    if ( ct && ct->range_bits >= 0 ) {
+        int32_t index = per_get_few_bits( pd, ct->range_bits );
+        if ( index < 0 || index > ct->upper_bound ) return false;
+        if ( specs->from_canonical_order ) index = specs->from_canonical_order[ index ];
+        if ( static_cast<unsigned>( index ) >= td->elements_count ) return false;
+
+        return skip( ctx, td->elements[ index ].type, td->elements[ index ].encoding_constraints.per_constraints, pd, depth + 1 );
+    }
+
+    // an extension alternative: its index, then the value as an open type.
+    if ( specs->ext_start == -1 || uper_get_nsnnwn( pd ) < 0 ) return false;
+    return skip_octets( pd );
+}
+
+bool skip_items( const asn_codec_ctx_t* ctx, const asn_TYPE_member_t& elm, long count, asn_per_data_t* pd, int depth ) {
+    for ( long i = 0; i < count; ++i ) {
+        if ( !skip( ctx, elm.type, elm.encoding_constraints.per_constraints, pd, depth + 1 ) ) return false;
+    }
+    return true;
+}
+
+bool skip_list( const asn_codec_ctx_t* ctx, const asn_TYPE_descriptor_t* td, const asn_per_constraints_t* constraints, asn_per_data_t* pd, int depth ) {
+    const asn_per_constraint_t* ct = constraints ? &constraints->size : nullptr;
+
+    if ( !read_extension( ct, pd ) ) return false;
+
+    // a size within the constraint's range has no length determinant, just an offset from the lower bound.
+    if ( ct && ct->effective_bits >= 0 ) {
+        int32_t count = per_get_few_bits( pd, ct->effective_bits );
+        if ( count < 0 ) return false;
+        return skip_items( ctx, td->elements[0], count + ct->lower_bound, pd, depth );
+    }
+
+    int repeat = 0;
+    do {
+        ssize_t count = uper_get_length( pd, -1, 0, &repeat );
+        if ( count < 0 || !skip_items( ctx, td->elements[0], count, pd, depth ) ) return false;
+    } while ( repeat );
+
+    return true;
+}
+
+bool skip_integer( const asn_per_constraints_t* constraints, asn_per_data_t* pd ) {
+    const asn_per_constraint_t* ct = constraints ? &constraints->value : nullptr;
+
+    if ( !read_extension( ct, pd ) ) return false;
+
+    if ( ct && !( ct->flags & asn_per_constraint_t::APC_SEMI_CONSTRAINED ) && ( ct->flags & asn_per_constraint_t::APC_CONSTRAINED ) && ct->range_bits >= 0 ) {
+        return skip_bits( pd, static_cast<std::size_t>( ct->range_bits ) );
+    }
+
+    return skip_octets( pd );
+}
+
+bool skip_enumerated( const asn_TYPE_descriptor_t* td, const asn_per_constraints_t* constraints, asn_per_data_t* pd ) {
+    const asn_INTEGER_specifics_t* specs = static_cast<const asn_INTEGER_specifics_t*>( td->specifics );
+
+    // like the asn1c decoder, an enumeration needs its constraint.
+    if ( !constraints ) return false;
+
+    const asn_per_constraint_t* ct = &constraints->value;
+    if ( !read_extension( ct, pd ) ) return false;
+
+    if ( ct && ct->range_bits >= 0 ) return skip_bits( pd, static_cast<std::size_t>( ct->range_bits ) );
+
+    if ( !specs || !specs->extension ) return false;
+    return uper_get_nsnnwn( pd ) >= 0;
+}
+
+/**
+ * Any other type is decoded with its own decoder and freed.
+ */
+bool decode_and_free( const asn_codec_ctx_t* ctx, const asn_TYPE_descriptor_t* td, const asn_per_constraints_t* constraints, asn_per_data_t* pd ) {
+    void* value = nullptr;
+    asn_dec_rval_t rval = td->op->uper_decoder( ctx, td, constraints, &value, pd );
+    if ( value ) ASN_STRUCT_FREE( *td, value );
+    return rval.code == RC_OK;
+}
+
+bool skip( const asn_codec_ctx_t* ctx, const asn_TYPE_descriptor_t* td, const asn_per_constraints_t* constraints, asn_per_data_t* pd, int depth ) {
+    if ( depth > max_depth ) return false;
+
+    // another skipped member inside this one.
+    if ( td->op->uper_decoder == decode_skipped ) td = reinterpret_cast<const Skipped*>( td )->original;
+
+    if ( !constraints ) constraints = td->encoding_constraints.per_constraints;
+    const asn_TYPE_operation_t* op = td->op;
+
+    if ( op == &asn_OP_SEQUENCE ) return skip_sequence( ctx, td, pd, depth );
+    if ( op == &asn_OP_CHOICE ) return skip_choice( ctx, td, constraints, pd, depth );
+    if ( op == &asn_OP_SEQUENCE_OF || op == &asn_OP_SET_OF ) return skip_list( ctx, td, constraints, pd, depth );
+    if ( op == &asn_OP_OPEN_TYPE ) return skip_octets( pd );
+    if ( op == &asn_OP_NativeInteger || op == &asn_OP_INTEGER ) return skip_integer( constraints, pd );
+    if ( op == &asn_OP_NativeEnumerated || op == &asn_OP_ENUMERATED ) return skip_enumerated( td, constraints, pd );
+    if ( op == &asn_OP_BOOLEAN ) return per_get_few_bits( pd, 1 ) >= 0;
+    if ( op == &asn_OP_NULL ) return true;
+
+    return decode_and_free( ctx, td, constraints, pd );
+}
+
+const asn_TYPE_descriptor_t* unskipped( const asn_TYPE_descriptor_t* td ) {
+    return td->op->uper_decoder == decode_skipped ? reinterpret_cast<const Skipped*>( td )->original : td;
+}
+
+/**
+ * The member of a constructed type named by one path step.
+ */
+asn_TYPE_member_t* find_member( const asn_TYPE_descriptor_t* td, const std::string& name ) {
+    const asn_TYPE_operation_t* op = td->op;
+
+    if ( op == &asn_OP_SEQUENCE || op == &asn_OP_CHOICE || op == &asn_OP_OPEN_TYPE ) {
+        for ( unsigned i = 0; i < td->elements_count; ++i ) {
+            if ( name == td->elements[i].name ) return &td->elements[i];
+        }
+    } else if ( op == &asn_OP_SEQUENCE_OF || op == &asn_OP_SET_OF ) {
+        asn_TYPE_member_t& elm = td->elements[0];
+        if ( name == ( *elm.name ? elm.name : elm.type->xml_tag ) ) return &elm;
+    }
+
+    return nullptr;
+}
+
+}  // end namespace.
+
+bool uper_skip::skip_member( const asn_TYPE_descriptor_t* td, const std::string& path, std::string& error ) {
+    asn_TYPE_member_t* member = nullptr;
+    const asn_TYPE_descriptor_t* parent = td;
+
+    std::size_t begin = 0;
+    while ( true ) {
+        std::size_t end = path.find( '/', begin );
+        std::string step = path.substr( begin, end == std::string::npos ? std::string::npos : end - begin );
+
+        if ( member ) parent = unskipped( member->type );
+        member = find_member( parent, step );
+        if ( !member ) {
+            error = std::string{ parent->name } + " has no member " + step;
+            return false;
+        }
+
+        if ( end == std::string::npos ) break;
+        begin = end + 1;
+    }
+
+    if ( member->type->op->uper_decoder == decode_skipped ) return true;
+
+    if ( parent->op != &asn_OP_SEQUENCE || !member->optional || !( member->flags & ATF_POINTER ) ) {
+        error = path + " is not an OPTIONAL member of a SEQUENCE";
+        return false;
+    }
+
+    // the SEQUENCE decoder reads an open type through its selector, not the member's descriptor.
+    if ( member->flags & ATF_OPEN_TYPE ) {
+        error = path + " is an open type";
+        return false;
+    }
+
+    std::unique_ptr<Skipped> skipped{ new Skipped };
+    skipped->original = member->type;
+    skipped->member = member;
+    skipped->op = *member->type->op;
+    skipped->op.uper_decoder = decode_skipped;
+    skipped->td = *member->type;
+    skipped->td.op = &skipped->op;
+
+    member->type = &skipped->td;
+    skipped_members.push_back( std::move( skipped ) );
+    return true;
+}
+
+void uper_skip::restore() {
+    for ( auto it = skipped_members.rbegin(); it != skipped_members.rend(); ++it ) {
+        ( *it )->member->type = ( *it )->original;
+    }
+    skipped_members.clear();
+}
+
+bool uper_skip::skip_value( const asn_codec_ctx_t* opt_codec_ctx, const asn_TYPE_descriptor_t* td, const asn_per_constraints_t* constraints, asn_per_data_t* pd ) {
+    return skip( opt_codec_ctx, td, constraints, pd, 0 );
+}
@@ -0,0 +1,135 @@
+/**
+ * @file
+ *
+ * @copyright Copyright 2017 US DOT - Joint Program Office
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License")
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *    Oak Ridge National Laboratory, Center for Trustworthy Embedded Systems, UT Battelle.
+ */
+
+#include "xml_splice.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+static bool is_xml_space( char c ) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+void XmlSplice::reset( const char* input, std::size_t size ) {
+    input_ = input;
+    size_ = size;
+    valid_ = input != nullptr;
+    splices_.clear();
+}
+
+bool XmlSplice::replace_content( pugi::xml_node element ) {
+    Splice splice{ 0, 0, element };
+
+    if ( !valid_ || element.type() != pugi::node_element || !find_content( element, splice.begin, splice.end ) ) {
+        valid_ = false;
+        return false;
+    }
+
+    auto it = std::lower_bound( splices_.begin(), splices_.end(), splice,
+            []( const Splice& a, const Splice& b ) { return a.begin < b.begin; } );
+
+    // nested or repeated elements cannot both be replaced.
+    if ( ( it != splices_.end() && it->begin < splice.end ) || ( it != splices_.begin() && ( it - 1 )->end > splice.begin ) ) {
+        valid_ = false;
+        return false;
+    }
+
+    splices_.insert( it, splice );
+    return true;
+}
+
+void XmlSplice::write( pugi::xml_writer& output ) const {
+    static const char declaration[] = "<?xml version=\"1.0\"?>";
+
+    // save() adds a declaration when the input has none; keep the output the same.
+    bool has_declaration = false;
+    for ( pugi::xml_node n = splices_.front().element.root().first_child(); n && !has_declaration; n = n.next_sibling() ) {
+        has_declaration = n.type() == pugi::node_declaration;
+    }
+    if ( !has_declaration ) output.write( declaration, sizeof declaration - 1 );
+
+    std::size_t pos = 0;
+    for ( const Splice& splice : splices_ ) {
+        output.write( input_ + pos, splice.begin - pos );
+        for ( pugi::xml_node child = splice.element.first_child(); child; child = child.next_sibling() ) {
+            child.print( output, "", pugi::format_raw );
+        }
+        pos = splice.end;
+    }
+    output.write( input_ + pos, size_ - pos );
+}
+
+bool XmlSplice::find_content( pugi::xml_node element, std::size_t& begin, std::size_t& end ) const {
+    const char* name = element.name();
+    std::size_t name_len = std::strlen( name );
+
+    // pugixml reports where the element's name is in its copy of the input; confirm the input agrees.
+    std::ptrdiff_t offset = element.offset_debug();
+    if ( offset < 1 || static_cast<std::size_t>( offset ) + name_len > size_ ) return false;
+
+    std::size_t i = static_cast<std::size_t>( offset );
+    if ( input_[ i - 1 ] != '<' || std::memcmp( input_ + i, name, name_len ) != 0 ) return false;
+
+    // the end of the start tag; attribute values may contain '>'.
+    char quote = 0;
+    for ( i += name_len; i < size_; ++i ) {
+        char c = input_[i];
+        if ( quote ) {
+            if ( c == quote ) quote = 0;
+        } else if ( c == '"' || c == '\'' ) {
+            quote = c;
+        } else if ( c == '>' ) {
+            break;
+        }
+    }
+
+    // a self-closing element has no place to put content.
+    if ( i >= size_ || input_[ i - 1 ] == '/' ) return false;
+    begin = i + 1;
+
+    // the end tag is the last one with this name before the next node outside this element.
+    std::size_t limit = size_;
+    for ( pugi::xml_node n = element; n; n = n.parent() ) {
+        pugi::xml_node next = n.next_sibling();
+        if ( next ) {
+            std::ptrdiff_t next_offset = next.offset_debug();
+            if ( next_offset < 0 ) return false;
+            limit = static_cast<std::size_t>( next_offset );
+            break;
+        }
+    }
+
+    if ( limit > size_ || limit < begin + name_len + 2 ) return false;
+
+    for ( std::size_t j = limit - name_len - 1; j-- > begin; ) {
+        if ( input_[j] != '<' || input_[ j + 1 ] != '/' || std::memcmp( input_ + j + 2, name, name_len ) != 0 ) continue;
+
+        std::size_t k = j + 2 + name_len;
+        while ( k < limit && is_xml_space( input_[k] ) ) ++k;
+
+        if ( k < limit && input_[k] == '>' ) {
+            end = j;
+            return true;
+        }
+    }
+
+    return false;
+}